@@ -0,0 +1,164 @@
+#pragma once
+// An open addressing hash table of positions into a sequence kept elsewhere,
+// for C++14 or above.
+//
+// The table never sees a key: it stores the hash and the position of each
+// entry, and asks the caller whether the entry at a position is the one
+// being looked up. That way the sequence can be a plain `std::vector`
+// (or several of them) and still be looked up by key.
+//
+// Linear probing with backward shift deletion, so there are no tombstones.
+// The slots come from Allocator, rebound; `position_index` uses `std::allocator`.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace nonstd
+{
+    namespace fifo_detail
+    {
+        template <class Allocator>
+        struct basic_position_index final
+        {
+            using size_type = std::size_t;
+            using allocator_type = Allocator;
+            static constexpr size_type npos = size_type(-1);
+
+            basic_position_index() = default;
+            explicit basic_position_index(allocator_type const& a): slots(slot_allocator{a}) {}
+
+            // Position of the entry for which equal_at(position) holds,
+            // or npos if there isn't one.
+            template <class Equal_At>
+            auto find(std::size_t hash, Equal_At&& equal_at) const -> size_type
+            {
+                if (slots.empty()) return npos;
+
+                for (auto i = home_of(hash); ; i = (i + 1) & mask()) {
+                    auto&& s = slots[i];
+                    if (s.position == npos) return npos;
+                    if (s.hash == hash && equal_at(s.position)) return s.position;
+                }
+            }
+
+            // The entry must not be in the index already.
+            auto insert(std::size_t hash, size_type position) -> void
+            {
+                reserve(count + 1);
+
+                auto i = home_of(hash);
+                while (slots[i].position != npos)
+                    i = (i + 1) & mask();
+
+                slots[i] = { hash, position };
+                ++count;
+            }
+
+            auto erase(std::size_t hash, size_type position) -> void
+            {
+                auto i = home_of(hash);
+                while (slots[i].position != position)
+                    i = (i + 1) & mask();
+
+                for (auto j = (i + 1) & mask(); slots[j].position != npos; j = (j + 1) & mask()) {
+                    auto home = home_of(slots[j].hash);
+                    if (((j - home) & mask()) >= ((j - i) & mask())) {
+                        slots[i] = slots[j];
+                        i = j;
+                    }
+                }
+
+                slots[i].position = npos;
+                --count;
+            }
+
+            // Every position after `position` moves one step towards the front,
+            // as happens when the entry at `position` is erased from the sequence.
+            auto shift_down_after(size_type position) -> void
+            {
+                for (auto&& s: slots)
+                    if (s.position != npos && s.position > position)
+                        --s.position;
+            }
+
+            // Every position from `position` on moves one step towards the back,
+            // as happens when an entry is inserted at `position` in the sequence.
+            auto shift_up_from(size_type position) -> void
+            {
+                for (auto&& s: slots)
+                    if (s.position != npos && s.position >= position)
+                        ++s.position;
+            }
+
+            auto reserve(size_type n) -> void
+            {
+                if (n * 4 <= slots.size() * 3) return;
+
+                size_type capacity = 8;
+                while (n * 4 > capacity * 3) capacity <<= 1;
+                rehash(capacity);
+            }
+
+            auto clear() -> void
+            {
+                slots.clear();
+                count = 0;
+            }
+
+            auto size() const -> size_type
+            {
+                return count;
+            }
+
+        private:
+            struct slot final
+            {
+                std::size_t hash;
+                size_type position{npos};
+            };
+
+            using slot_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<slot>;
+
+            auto mask() const -> size_type
+            {
+                return slots.size() - 1;
+            }
+
+            // Fibonacci hashing; std::hash of integers is usually the identity.
+            auto home_of(std::size_t hash) const -> size_type
+            {
+                return size_type((std::uint64_t(hash) * 0x9E3779B97F4A7C15ull) >> shift);
+            }
+
+            auto rehash(size_type capacity) -> void
+            {
+                std::vector<slot, slot_allocator> old(capacity, slot{}, slots.get_allocator());
+                old.swap(slots);
+
+                shift = 64;
+                while (capacity >>= 1) --shift;
+
+                for (auto&& s: old) {
+                    if (s.position == npos) continue;
+
+                    auto i = home_of(s.hash);
+                    while (slots[i].position != npos)
+                        i = (i + 1) & mask();
+                    slots[i] = s;
+                }
+            }
+
+            std::vector<slot, slot_allocator> slots;
+            size_type count{};
+            // 64 - log2(capacity)
+            unsigned shift{64};
+        };
+
+        using position_index = basic_position_index<std::allocator<std::size_t>>;
+    }
+}
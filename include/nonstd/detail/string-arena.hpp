@@ -0,0 +1,57 @@
+#pragma once
+// Append-only storage for string bytes, in big chunks that never move,
+// for C++17 or above.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+
+namespace nonstd
+{
+    namespace fifo_detail
+    {
+        // `store` copies bytes in and returns a view of the copy.
+        struct string_arena final
+        {
+            using size_type = std::size_t;
+
+            auto store(std::string_view s) -> std::string_view
+            {
+                if (s.empty()) return {};
+                if (chunks.empty() || s.size() > room) grow(s.size());
+
+                auto at = chunks.back().get() + (chunk_size - room);
+                std::memcpy(at, s.data(), s.size());
+                room -= s.size();
+                return { at, s.size() };
+            }
+
+            auto clear() -> void
+            {
+                chunks.clear();
+                chunk_size = room = 0;
+            }
+
+        private:
+            static constexpr size_type min_chunk_size = 4096;
+            static constexpr size_type max_chunk_size = 1 << 20;
+
+            auto grow(size_type n) -> void
+            {
+                chunk_size = std::max(n, std::min(std::max(chunk_size * 2, min_chunk_size), max_chunk_size));
+                chunks.emplace_back(new char[chunk_size]);
+                room = chunk_size;
+            }
+
+            std::vector<std::unique_ptr<char[]>> chunks;
+            size_type chunk_size{};
+            // free bytes at the end of the last chunk
+            size_type room{};
+        };
+    }
+}
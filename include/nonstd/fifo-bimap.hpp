@@ -0,0 +1,259 @@
+#pragma once
+// A bidirectional hash map that guarantees iteration in insertion-order,
+// for C++14 or above.
+//
+// Every entry is a pair of a left key and a right key, both unique, kept in
+// one `std::list` node. Two lookup indexes built using `std::unordered_map`
+// refer into the same nodes, so either side finds the pair in O(1), and
+// erasing by either side removes it from both.
+//
+// Entries can't be modified in place, as both halves are keys;
+// erase and emplace again instead.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-key-reference.hpp"
+#include <unordered_map>
+#include <list>
+#include <stdexcept>
+#include <cassert>
+
+namespace nonstd
+{
+    template <
+        class Left
+        , class Right
+        , class Left_Hash = std::hash<Left>
+        , class Right_Hash = std::hash<Right>
+        , class Left_Equal = std::equal_to<Left>
+        , class Right_Equal = std::equal_to<Right>
+    >
+    struct fifo_bimap final
+    {
+        using left_type = Left;
+        using right_type = Right;
+        using left_hasher = Left_Hash;
+        using right_hasher = Right_Hash;
+        using left_equal = Left_Equal;
+        using right_equal = Right_Equal;
+
+        using value_type = std::pair<left_type const, right_type const>;
+        using list_type = std::list<value_type>;
+        using list_iterator = typename list_type::iterator;
+        using list_const_iterator = typename list_type::const_iterator;
+        using iterator = list_const_iterator;
+        using const_iterator = list_const_iterator;
+        using reverse_iterator = typename list_type::const_reverse_iterator;
+        using const_reverse_iterator = typename list_type::const_reverse_iterator;
+
+        using left_reference = fifo_key_reference<left_type, left_hasher, left_equal>;
+        using right_reference = fifo_key_reference<right_type, right_hasher, right_equal>;
+
+        template <class Reference>
+        struct reference_hasher final
+        {
+            auto operator () (Reference const& r) const -> std::size_t
+            {
+                return r.hash();
+            }
+        };
+
+        using left_map_type = std::unordered_map<left_reference, list_iterator, reference_hasher<left_reference>>;
+        using right_map_type = std::unordered_map<right_reference, list_iterator, reference_hasher<right_reference>>;
+        using size_type = typename left_map_type::size_type;
+
+        // rule of five; force noexcept move constructible
+        fifo_bimap() = default;
+
+        fifo_bimap(fifo_bimap const& x)
+        {
+            for (auto&& lr: x)
+                emplace_back(lr);
+        }
+
+        auto operator = (fifo_bimap const& x) -> fifo_bimap&
+        {
+            if (this != &x) {
+                clear();
+                for (auto&& lr: x)
+                    emplace_back(lr);
+            }
+            return *this;
+        }
+
+        fifo_bimap(fifo_bimap&& other) noexcept
+            : left_map{std::move(other.left_map)}
+            , right_map{std::move(other.right_map)}
+            , list{std::move(other.list)}
+        {}
+
+        auto operator = (fifo_bimap&& other) noexcept -> fifo_bimap&
+        {
+            left_map = std::move(other.left_map);
+            right_map = std::move(other.right_map);
+            list = std::move(other.list);
+            return *this;
+        }
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        // Fails if either side is taken already, and returns the entry that has it.
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(list.end(), std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(list.begin(), std::forward<Args>(args)...);
+        }
+
+        auto erase(const_iterator it) -> void
+        {
+            auto left_it = left_map.find(it->first);
+            assert(left_it != left_map.end());
+
+            auto list_it = left_it->second;
+            left_map.erase(left_it);
+            right_map.erase(list_it->second);
+            list.erase(list_it);
+        }
+
+        auto erase_left(left_type const& l) -> void
+        {
+            auto it = find_left(l);
+            if (it == end()) return;
+            erase(it);
+        }
+
+        auto erase_right(right_type const& r) -> void
+        {
+            auto it = find_right(r);
+            if (it == end()) return;
+            erase(it);
+        }
+
+        auto clear() -> void
+        {
+            left_map.clear();
+            right_map.clear();
+            list.clear();
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            left_map.reserve(n);
+            right_map.reserve(n);
+        }
+
+        auto count_left(left_type const& l) const -> size_type
+        {
+            return left_map.count(l);
+        }
+
+        auto count_right(right_type const& r) const -> size_type
+        {
+            return right_map.count(r);
+        }
+
+        auto size() const -> size_type
+        {
+            return list.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return list.empty();
+        }
+
+        auto find_left(left_type const& l) const -> const_iterator
+        {
+            auto map_it = left_map.find(l);
+            if (map_it == left_map.end())
+                return end();
+            return map_it->second;
+        }
+
+        auto find_right(right_type const& r) const -> const_iterator
+        {
+            auto map_it = right_map.find(r);
+            if (map_it == right_map.end())
+                return end();
+            return map_it->second;
+        }
+
+        // The right key paired with l.
+        auto at_left(left_type const& l) const -> right_type const&
+        {
+            auto it = find_left(l);
+            if (it == end()) throw std::out_of_range{"fifo_bimap::at_left"};
+            return it->second;
+        }
+
+        // The left key paired with r.
+        auto at_right(right_type const& r) const -> left_type const&
+        {
+            auto it = find_right(r);
+            if (it == end()) throw std::out_of_range{"fifo_bimap::at_right"};
+            return it->first;
+        }
+
+        auto begin() const -> const_iterator { return list.begin(); }
+        auto   end() const -> const_iterator { return list.  end(); }
+        auto cbegin() const -> const_iterator { return list.cbegin(); }
+        auto   cend() const -> const_iterator { return list.  cend(); }
+        auto rbegin() const -> const_reverse_iterator { return list.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return list.  rend(); }
+        auto crbegin() const -> const_reverse_iterator { return list.crbegin(); }
+        auto   crend() const -> const_reverse_iterator { return list.  crend(); }
+
+        // Oldest and newest entries; the bimap must not be empty.
+        auto front() const -> value_type const& { return list.front(); }
+        auto  back() const -> value_type const& { return list. back(); }
+
+    private:
+        template <class... Args>
+        auto insert_at(list_const_iterator where, Args&&... args) -> std::pair<iterator, bool>
+        {
+            // not value_type, whose const members can't be moved from
+            std::pair<left_type, right_type> value{std::forward<Args>(args)...};
+
+            auto left_it = left_map.find(value.first);
+            if (left_it != left_map.end())
+                return { left_it->second, false };
+
+            auto right_it = right_map.find(value.second);
+            if (right_it != right_map.end())
+                return { right_it->second, false };
+
+            auto list_it = list.emplace(where, std::move(value.first), std::move(value.second));
+            try {
+                left_it = left_map.emplace(list_it->first, list_it).first;
+            } catch (...) {
+                list.erase(list_it);
+                throw;
+            }
+            try {
+                right_map.emplace(list_it->second, list_it);
+            } catch (...) {
+                // no half-registered pairs
+                left_map.erase(left_it);
+                list.erase(list_it);
+                throw;
+            }
+            return { list_it, true };
+        }
+
+        left_map_type left_map;
+        right_map_type right_map;
+        list_type list;
+    };
+}
@@ -0,0 +1,285 @@
+#pragma once
+// An approximate set that remembers insertion-order, in a bounded amount of
+// memory, for C++14 or above.
+//
+// Keys aren't stored, only 16-bit fingerprints of them in a cuckoo filter:
+// buckets of four fingerprints packed in an `std::uint64_t`, each key having
+// two candidate buckets. A lookup compares a fingerprint against all four at
+// once with a few integer operations. `count` may say a key is there when
+// it isn't (about once per 8000 lookups when full), but never the opposite.
+//
+// A ring of (bucket, fingerprint) entries keeps insertion-order, so the
+// oldest key can be erased with `pop_front`. The filter holds at most
+// `capacity()` keys; inserting one more erases the oldest first, so it's a
+// sliding window over the latest keys, at 10 to 13 bytes per key, and a
+// table entry per key repeated within the window.
+//
+// Every insertion gets its own ring entry, so repeats count towards the
+// capacity and `size` counts insertions, not distinct keys. A key that's
+// already there (or whose fingerprint is, in the same two buckets) isn't
+// stored again: a side table counts its extra entries, and its fingerprint
+// goes when the last of them is popped. So a hot key takes one lane however
+// often it comes, and never pushes other keys out.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+namespace nonstd
+{
+    namespace fifo_detail
+    {
+        // Every bit of the result depends on every bit of x.
+        inline auto mix64(std::uint64_t x) -> std::uint64_t
+        {
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdull;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ull;
+            x ^= x >> 33;
+            return x;
+        }
+
+        // Whether any of the four 16-bit lanes of bucket equals fingerprint.
+        inline auto bucket_has(std::uint64_t bucket, std::uint16_t fingerprint) -> bool
+        {
+            auto x = bucket ^ (fingerprint * 0x0001000100010001ull);
+            return ((x - 0x0001000100010001ull) & ~x & 0x8000800080008000ull) != 0;
+        }
+    }
+
+    template <
+        class Key
+        , class Hash = std::hash<Key>
+    >
+    struct fifo_cuckoo_filter final
+    {
+        using key_type = Key;
+        using hasher = Hash;
+        using size_type = std::size_t;
+
+        // Room for capacity keys; throws std::length_error if it's 0 or absurd.
+        explicit fifo_cuckoo_filter(size_type capacity)
+            : ring(checked(capacity))
+        {
+            // at most 8/9 full, for insertions to rarely run out of kicks
+            auto slots = capacity + capacity / 8;
+            size_type bucket_count = 1;
+            while (bucket_count * 4 < slots) bucket_count *= 2;
+            buckets.resize(bucket_count);
+        }
+
+        // Inserts key as the newest, erasing the oldest keys if there's no
+        // room; returns false if it may already have been there.
+        auto insert(key_type const& key) -> bool
+        {
+            std::uint16_t fingerprint;
+            size_type i;
+            locate(key, fingerprint, i);
+
+            if (count_all == ring.size()) pop_front();
+
+            auto fresh = !fifo_detail::bucket_has(buckets[i], fingerprint) && !fifo_detail::bucket_has(buckets[alternate(i, fingerprint)], fingerprint);
+            if (fresh) {
+                while (!place(i, fingerprint))
+                    pop_front();
+            } else {
+                repeats[pair_of(i, fingerprint)]++;
+            }
+
+            ring[(head + count_all) % ring.size()] = (std::uint64_t(i) << 16) | fingerprint;
+            count_all++;
+            return fresh;
+        }
+
+        // 1 if key may be there, 0 if it surely isn't.
+        auto count(key_type const& key) const -> size_type
+        {
+            std::uint16_t fingerprint;
+            size_type i;
+            locate(key, fingerprint, i);
+
+            return (fifo_detail::bucket_has(buckets[i], fingerprint) || fifo_detail::bucket_has(buckets[alternate(i, fingerprint)], fingerprint)) ? 1 : 0;
+        }
+
+        // Erases the oldest key; the filter must not be empty.
+        auto pop_front() -> void
+        {
+            assert(count_all > 0);
+            auto entry = ring[head];
+            auto fingerprint = std::uint16_t(entry & 0xffff);
+            auto i = size_type(entry >> 16);
+
+            head = (head + 1) % ring.size();
+            count_all--;
+
+            auto repeat = repeats.find(pair_of(i, fingerprint));
+            if (repeat != repeats.end()) {
+                if (--repeat->second == 0) repeats.erase(repeat);
+                return;
+            }
+
+            auto removed = remove(i, fingerprint) || remove(alternate(i, fingerprint), fingerprint);
+            assert(removed);
+            (void) removed;
+        }
+
+        // Erases the oldest keys until at most n are left.
+        auto keep_newest(size_type n) -> void
+        {
+            while (count_all > n)
+                pop_front();
+        }
+
+        auto clear() -> void
+        {
+            std::fill(buckets.begin(), buckets.end(), 0);
+            repeats.clear();
+            head = 0;
+            count_all = 0;
+        }
+
+        auto size() const -> size_type
+        {
+            return count_all;
+        }
+
+        auto empty() const -> bool
+        {
+            return count_all == 0;
+        }
+
+        auto capacity() const -> size_type
+        {
+            return ring.size();
+        }
+
+    private:
+        static auto checked(size_type capacity) -> size_type
+        {
+            if (capacity == 0 || capacity > (size_type(1) << 40))
+                throw std::length_error{"fifo_cuckoo_filter"};
+            return capacity;
+        }
+
+        auto mask() const -> size_type
+        {
+            return buckets.size() - 1;
+        }
+
+        auto locate(key_type const& key, std::uint16_t& fingerprint, size_type& i) const -> void
+        {
+            hasher h{};
+            auto hash = fifo_detail::mix64(h(key));
+            // 0 marks an empty lane
+            fingerprint = std::uint16_t(hash >> 48);
+            if (fingerprint == 0) fingerprint = 1;
+            i = size_type(hash) & mask();
+        }
+
+        // The other bucket of a fingerprint in bucket i; alternate(alternate(i)) == i.
+        auto alternate(size_type i, std::uint16_t fingerprint) const -> size_type
+        {
+            return (i ^ size_type(fingerprint * 0x5bd1e995ull)) & mask();
+        }
+
+        // Names a fingerprint in bucket i, whichever of its two buckets it's
+        // in; kicks don't change it.
+        auto pair_of(size_type i, std::uint16_t fingerprint) const -> std::uint64_t
+        {
+            return (std::uint64_t(std::min(i, alternate(i, fingerprint))) << 16) | fingerprint;
+        }
+
+        static auto lane(std::uint64_t bucket, unsigned k) -> std::uint16_t
+        {
+            return std::uint16_t(bucket >> (16 * k));
+        }
+
+        static auto set_lane(std::uint64_t& bucket, unsigned k, std::uint16_t fingerprint) -> void
+        {
+            bucket &= ~(std::uint64_t(0xffff) << (16 * k));
+            bucket |= std::uint64_t(fingerprint) << (16 * k);
+        }
+
+        auto put(size_type i, std::uint16_t fingerprint) -> bool
+        {
+            if (!fifo_detail::bucket_has(buckets[i], 0)) return false;
+            for (unsigned k = 0; ; k++) {
+                if (lane(buckets[i], k) == 0) {
+                    set_lane(buckets[i], k, fingerprint);
+                    return true;
+                }
+            }
+        }
+
+        auto remove(size_type i, std::uint16_t fingerprint) -> bool
+        {
+            for (unsigned k = 0; k < 4; k++) {
+                if (lane(buckets[i], k) == fingerprint) {
+                    set_lane(buckets[i], k, 0);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Puts fingerprint in bucket i or its alternate, kicking others to
+        // their alternates if need be. If that goes on too long, undoes the
+        // kicks and returns false.
+        auto place(size_type i, std::uint16_t fingerprint) -> bool
+        {
+            if (put(i, fingerprint) || put(alternate(i, fingerprint), fingerprint))
+                return true;
+
+            constexpr unsigned max_kicks = 256;
+            struct kick final
+            {
+                size_type bucket;
+                unsigned lane;
+            };
+            kick kicks[max_kicks];
+
+            for (unsigned n = 0; n < max_kicks; n++) {
+                // xorshift, to not kick in cycles
+                random ^= random << 13;
+                random ^= random >> 7;
+                random ^= random << 17;
+
+                auto k = unsigned(random & 3);
+                auto kicked = lane(buckets[i], k);
+                set_lane(buckets[i], k, fingerprint);
+                kicks[n] = { i, k };
+
+                fingerprint = kicked;
+                i = alternate(i, fingerprint);
+                if (put(i, fingerprint)) return true;
+            }
+
+            for (auto n = max_kicks; n-- > 0; ) {
+                auto& b = buckets[kicks[n].bucket];
+                auto kicked = lane(b, kicks[n].lane);
+                set_lane(b, kicks[n].lane, fingerprint);
+                fingerprint = kicked;
+            }
+            return false;
+        }
+
+        std::vector<std::uint64_t> buckets;
+        // (bucket << 16 | fingerprint) in insertion-order, from head
+        std::vector<std::uint64_t> ring;
+        // pair_of a fingerprint with more than one entry in the ring:
+        // how many more
+        std::unordered_map<std::uint64_t, size_type> repeats;
+        size_type head{};
+        size_type count_all{};
+        std::uint64_t random{0x9e3779b97f4a7c15ull};
+    };
+}
@@ -0,0 +1,313 @@
+#pragma once
+// A hash map that keeps its entries contiguous, in insertion-order,
+// for C++14 or above.
+//
+// It's basically an `std::vector` of key/value pairs, with a lookup index
+// of positions into it. Iterators are random-access, `keys()` and `values()`
+// are random-access ranges over the entries, and `nth(i)` and `rank(key)`
+// are O(1), so the whole thing works with parallel and vectorized algorithms
+// the way an `std::vector` does.
+//
+// The price is paid on erase and emplace_front, which are O(n) like they
+// are for `std::vector`, and in `value_type`, which is `std::pair<Key, T>`
+// so that entries can be moved around. Don't modify keys through iterators.
+// Use `fifo_map` if you erase a lot.
+//
+// Both the entries and the index come from Allocator, so with an arena
+// allocator (say, `std::pmr::polymorphic_allocator` over a
+// `std::pmr::monotonic_buffer_resource`) the map never touches the heap.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "detail/position-index.hpp"
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <stdexcept>
+
+namespace nonstd
+{
+    namespace fifo_detail
+    {
+        // Random-access iterator over one member of the pairs
+        // another random-access iterator points to.
+        template <class Base, class Value, Value& (*Select)(typename std::iterator_traits<Base>::reference)>
+        struct projection_iterator final
+        {
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::remove_const_t<Value>;
+            using difference_type = typename std::iterator_traits<Base>::difference_type;
+            using pointer = Value*;
+            using reference = Value&;
+
+            projection_iterator() = default;
+            explicit projection_iterator(Base base): base{base} {}
+
+            auto operator *  () const -> reference { return Select(*base); }
+            auto operator -> () const -> pointer { return &Select(*base); }
+            auto operator [] (difference_type n) const -> reference { return Select(base[n]); }
+
+            auto operator ++ () -> projection_iterator& { ++base; return *this; }
+            auto operator -- () -> projection_iterator& { --base; return *this; }
+            auto operator ++ (int) -> projection_iterator { return projection_iterator{base++}; }
+            auto operator -- (int) -> projection_iterator { return projection_iterator{base--}; }
+            auto operator += (difference_type n) -> projection_iterator& { base += n; return *this; }
+            auto operator -= (difference_type n) -> projection_iterator& { base -= n; return *this; }
+
+            friend auto operator + (projection_iterator it, difference_type n) -> projection_iterator { return it += n; }
+            friend auto operator + (difference_type n, projection_iterator it) -> projection_iterator { return it += n; }
+            friend auto operator - (projection_iterator it, difference_type n) -> projection_iterator { return it -= n; }
+            friend auto operator - (projection_iterator const& a, projection_iterator const& b) -> difference_type { return a.base - b.base; }
+
+            friend auto operator == (projection_iterator const& a, projection_iterator const& b) -> bool { return a.base == b.base; }
+            friend auto operator != (projection_iterator const& a, projection_iterator const& b) -> bool { return a.base != b.base; }
+            friend auto operator <  (projection_iterator const& a, projection_iterator const& b) -> bool { return a.base <  b.base; }
+            friend auto operator >  (projection_iterator const& a, projection_iterator const& b) -> bool { return a.base >  b.base; }
+            friend auto operator <= (projection_iterator const& a, projection_iterator const& b) -> bool { return a.base <= b.base; }
+            friend auto operator >= (projection_iterator const& a, projection_iterator const& b) -> bool { return a.base >= b.base; }
+
+        private:
+            Base base{};
+        };
+
+        template <class Iterator>
+        struct iterator_range final
+        {
+            using iterator = Iterator;
+            using size_type = std::size_t;
+
+            iterator_range(iterator first, iterator last): first{first}, last{last} {}
+
+            auto begin() const -> iterator { return first; }
+            auto   end() const -> iterator { return last; }
+            auto size() const -> size_type { return size_type(last - first); }
+            auto empty() const -> bool { return first == last; }
+            auto operator [] (size_type i) const -> decltype(auto) { return first[i]; }
+
+        private:
+            iterator first;
+            iterator last;
+        };
+    }
+
+    template <
+        class Key
+        , class T
+        , class Hash = std::hash<Key>
+        , class Key_Equal = std::equal_to<Key>
+        , class Allocator = std::allocator<std::pair<Key, T>>
+    >
+    struct fifo_dense_map final
+    {
+        using key_type = Key;
+        using mapped_type = T;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+        using allocator_type = Allocator;
+
+        using value_type = std::pair<key_type, mapped_type>;
+        // Allocator may be for any type, like the index's
+        using vector_type = std::vector<value_type, typename std::allocator_traits<allocator_type>::template rebind_alloc<value_type>>;
+        using iterator = typename vector_type::iterator;
+        using const_iterator = typename vector_type::const_iterator;
+        using reverse_iterator = typename vector_type::reverse_iterator;
+        using const_reverse_iterator = typename vector_type::const_reverse_iterator;
+
+        using index_type = fifo_detail::basic_position_index<allocator_type>;
+        using size_type = typename index_type::size_type;
+
+    private:
+        static auto select_key(value_type const& kv) -> key_type const& { return kv.first; }
+        static auto select_value(value_type& kv) -> mapped_type& { return kv.second; }
+        static auto select_const_value(value_type const& kv) -> mapped_type const& { return kv.second; }
+
+    public:
+        using key_iterator = fifo_detail::projection_iterator<const_iterator, key_type const, &select_key>;
+        using value_iterator = fifo_detail::projection_iterator<iterator, mapped_type, &select_value>;
+        using const_value_iterator = fifo_detail::projection_iterator<const_iterator, mapped_type const, &select_const_value>;
+        using key_range = fifo_detail::iterator_range<key_iterator>;
+        using value_range = fifo_detail::iterator_range<value_iterator>;
+        using const_value_range = fifo_detail::iterator_range<const_value_iterator>;
+
+        fifo_dense_map() = default;
+        explicit fifo_dense_map(allocator_type const& a): entries(typename vector_type::allocator_type(a)), index(a) {}
+
+        auto get_allocator() const -> allocator_type
+        {
+            return allocator_type(entries.get_allocator());
+        }
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto hash = hash_of(value.first);
+            auto position = find_position(hash, value.first);
+            if (position != index_type::npos)
+                return { begin() + position, false };
+
+            index.reserve(size() + 1);
+            entries.push_back(std::move(value));
+            index.insert(hash, entries.size() - 1);
+
+            return { end() - 1, true };
+        }
+
+        // O(n), every entry moves.
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto hash = hash_of(value.first);
+            auto position = find_position(hash, value.first);
+            if (position != index_type::npos)
+                return { begin() + position, false };
+
+            index.reserve(size() + 1);
+            entries.insert(entries.begin(), std::move(value));
+            index.shift_up_from(0);
+            index.insert(hash, 0);
+
+            return { begin(), true };
+        }
+
+        // O(n), every entry after it moves.
+        auto erase(const_iterator it) -> void
+        {
+            auto position = size_type(it - cbegin());
+            index.erase(hash_of(it->first), position);
+            index.shift_down_after(position);
+            entries.erase(entries.begin() + position);
+        }
+
+        auto erase(key_type const& key) -> void
+        {
+            auto it = find(key);
+            if (it == end()) return;
+            erase(it);
+        }
+
+        auto clear() -> void
+        {
+            index.clear();
+            entries.clear();
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            index.reserve(n);
+            entries.reserve(n);
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            return (find_position(hash_of(key), key) == index_type::npos ? 0 : 1);
+        }
+
+        auto size() const -> size_type
+        {
+            return entries.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return entries.empty();
+        }
+
+        auto find(key_type const& key) const -> const_iterator
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos)
+                return end();
+            return begin() + position;
+        }
+
+        auto find(key_type const& key) -> iterator
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos)
+                return end();
+            return begin() + position;
+        }
+
+        // The i-th entry in insertion-order, or end() if there isn't one.
+        auto nth(size_type i) const -> const_iterator { return (i < size() ? begin() + i : end()); }
+        auto nth(size_type i) -> iterator { return (i < size() ? begin() + i : end()); }
+
+        // Position of key in insertion-order, or size() if there isn't one.
+        auto rank(key_type const& key) const -> size_type
+        {
+            auto position = find_position(hash_of(key), key);
+            return (position == index_type::npos ? size() : position);
+        }
+
+        auto at(key_type const& key) const -> mapped_type const&
+        {
+            auto it = find(key);
+            if (it == end()) throw std::out_of_range{"fifo_dense_map::at"};
+            return it->second;
+        }
+
+        auto at(key_type const& key) -> mapped_type&
+        {
+            auto it = find(key);
+            if (it == end()) throw std::out_of_range{"fifo_dense_map::at"};
+            return it->second;
+        }
+
+        auto operator [] (key_type const& key) -> mapped_type&
+        {
+            auto it = find(key);
+            if (it != end())
+                return it->second;
+
+            return emplace(key, mapped_type{}).first->second;
+        }
+
+        auto keys() const -> key_range { return { key_iterator{cbegin()}, key_iterator{cend()} }; }
+        auto values() -> value_range { return { value_iterator{begin()}, value_iterator{end()} }; }
+        auto values() const -> const_value_range { return { const_value_iterator{cbegin()}, const_value_iterator{cend()} }; }
+
+        auto data() -> value_type* { return entries.data(); }
+        auto data() const -> value_type const* { return entries.data(); }
+
+        auto begin() -> iterator { return entries.begin(); }
+        auto   end() -> iterator { return entries.  end(); }
+        auto begin() const -> const_iterator { return entries.begin(); }
+        auto   end() const -> const_iterator { return entries.  end(); }
+        auto cbegin() const -> const_iterator { return entries.cbegin(); }
+        auto   cend() const -> const_iterator { return entries.  cend(); }
+        auto rbegin() -> reverse_iterator { return entries.rbegin(); }
+        auto   rend() -> reverse_iterator { return entries.  rend(); }
+        auto rbegin() const -> const_reverse_iterator { return entries.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return entries.  rend(); }
+
+    private:
+        static auto hash_of(key_type const& key) -> std::size_t
+        {
+            hasher h{};
+            return h(key);
+        }
+
+        auto find_position(std::size_t hash, key_type const& key) const -> size_type
+        {
+            key_equal eq{};
+            return index.find(hash, [&] (size_type position) {
+                return eq(entries[position].first, key);
+            });
+        }
+
+        vector_type entries;
+        index_type index;
+    };
+}
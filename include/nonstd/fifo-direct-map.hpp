@@ -0,0 +1,287 @@
+#pragma once
+// A map from integers that guarantees iteration in insertion-order,
+// for C++14 or above.
+//
+// Like `fifo_map`, it's an `std::list` of key/value pairs, but keys inside
+// a range given up front are looked up in a plain array indexed by
+// `key - lowest`: one load, no hashing. Keys outside the range still work;
+// they fall back to an `std::unordered_map`.
+//
+// Good for ports, small IDs, enum-like codes. The array costs one slot
+// per key in the range whether it's used or not, so keep the range compact.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <type_traits>
+#include <stdexcept>
+#include <limits>
+#include <cstdint>
+#include <cassert>
+
+namespace nonstd
+{
+    template <
+        class Key
+        , class T
+        , class Hash = std::hash<Key>
+    >
+    struct fifo_direct_map final
+    {
+        static_assert(std::is_integral<Key>::value && !std::is_same<std::remove_cv_t<Key>, bool>::value,
+            "fifo_direct_map keys must be integers other than bool");
+
+        using key_type = Key;
+        using mapped_type = T;
+        using hasher = Hash;
+
+        using value_type = std::pair<key_type const, mapped_type>;
+        using list_type = std::list<value_type>;
+        using list_iterator = typename list_type::iterator;
+        using list_const_iterator = typename list_type::const_iterator;
+        using iterator = list_iterator;
+        using const_iterator = list_const_iterator;
+        using reverse_iterator = typename list_type::reverse_iterator;
+        using const_reverse_iterator = typename list_type::const_reverse_iterator;
+
+        using map_type = std::unordered_map<key_type, list_iterator, hasher>;
+        using size_type = typename map_type::size_type;
+
+        // Without a range every key falls back to hashing.
+        fifo_direct_map() = default;
+
+        // Keys in [lowest, highest] are looked up directly.
+        // Throws std::length_error if that's more slots than a vector can count.
+        fifo_direct_map(key_type lowest, key_type highest)
+            : lowest{lowest}
+            , table(table_size(lowest, highest))
+        {}
+
+        // rule of five; copies keep the range
+        fifo_direct_map(fifo_direct_map const& x)
+            : lowest{x.lowest}
+            , table(x.table.size())
+        {
+            for (auto&& kv: x)
+                emplace_back(kv);
+        }
+
+        auto operator = (fifo_direct_map const& x) -> fifo_direct_map&
+        {
+            if (this != &x) {
+                clear();
+                lowest = x.lowest;
+                table.resize(x.table.size());
+                for (auto&& kv: x)
+                    emplace_back(kv);
+            }
+            return *this;
+        }
+
+        fifo_direct_map(fifo_direct_map&&) noexcept = default;
+        auto operator = (fifo_direct_map&&) noexcept -> fifo_direct_map& = default;
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(list.end(), std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(list.begin(), std::forward<Args>(args)...);
+        }
+
+        auto erase(list_iterator list_it) -> void
+        {
+            auto s = slot_of(list_it->first);
+            if (s) {
+                assert(s->used);
+                s->used = false;
+            } else {
+                auto erased = map.erase(list_it->first);
+                assert(erased == 1);
+                (void) erased;
+            }
+            list.erase(list_it);
+        }
+
+        auto erase(key_type key) -> void
+        {
+            auto list_it = find(key);
+            if (list_it == end()) return;
+            erase(list_it);
+        }
+
+        auto clear() -> void
+        {
+            for (auto&& s: table)
+                s.used = false;
+            map.clear();
+            list.clear();
+        }
+
+        // Only the fallback index for keys out of range needs room.
+        auto reserve(size_type n) -> void
+        {
+            map.reserve(n);
+        }
+
+        auto count(key_type key) const -> size_type
+        {
+            return (find(key) == end() ? 0 : 1);
+        }
+
+        auto size() const -> size_type
+        {
+            return list.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return list.empty();
+        }
+
+        auto find(key_type key) const -> const_iterator
+        {
+            auto at = locate(key);
+            return (at ? *at : end());
+        }
+
+        auto find(key_type key) -> iterator
+        {
+            auto at = locate(key);
+            return (at ? *at : end());
+        }
+
+        auto at(key_type key) const -> mapped_type const&
+        {
+            auto it = find(key);
+            if (it == end()) throw std::out_of_range{"fifo_direct_map::at"};
+            return it->second;
+        }
+
+        auto at(key_type key) -> mapped_type&
+        {
+            auto it = find(key);
+            if (it == end()) throw std::out_of_range{"fifo_direct_map::at"};
+            return it->second;
+        }
+
+        auto operator [] (key_type key) -> mapped_type&
+        {
+            auto list_it = find(key);
+            if (list_it != end())
+                return list_it->second;
+
+            return emplace(key, mapped_type{}).first->second;
+        }
+
+        // Whether key is looked up directly rather than hashed.
+        auto in_range(key_type key) const -> bool
+        {
+            return (offset(key, lowest) < table.size());
+        }
+
+        auto begin() -> iterator { return list.begin(); }
+        auto   end() -> iterator { return list.  end(); }
+        auto begin() const -> const_iterator { return list.begin(); }
+        auto   end() const -> const_iterator { return list.  end(); }
+        auto cbegin() const -> const_iterator { return list.cbegin(); }
+        auto   cend() const -> const_iterator { return list.  cend(); }
+        auto rbegin() -> reverse_iterator { return list.rbegin(); }
+        auto   rend() -> reverse_iterator { return list.  rend(); }
+        auto rbegin() const -> const_reverse_iterator { return list.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return list.  rend(); }
+        auto crbegin() const -> const_reverse_iterator { return list.crbegin(); }
+        auto   crend() const -> const_reverse_iterator { return list.  crend(); }
+
+        // Oldest and newest entries; the map must not be empty.
+        auto front() -> value_type& { return list.front(); }
+        auto  back() -> value_type& { return list. back(); }
+        auto front() const -> value_type const& { return list.front(); }
+        auto  back() const -> value_type const& { return list. back(); }
+
+    private:
+        using offset_type = std::make_unsigned_t<key_type>;
+
+        struct slot final
+        {
+            list_iterator at;
+            bool used{};
+        };
+
+        // Keys below lowest wrap around to huge offsets, so one compare
+        // tells whether a key is in range.
+        static auto offset(key_type key, key_type lowest) -> offset_type
+        {
+            return offset_type(offset_type(key) - offset_type(lowest));
+        }
+
+        static auto table_size(key_type lowest, key_type highest) -> size_type
+        {
+            if (highest < lowest) return 0;
+            auto span = offset(highest, lowest);
+            if (std::uintmax_t(span) >= std::numeric_limits<size_type>::max())
+                throw std::length_error{"fifo_direct_map: range too wide"};
+            return size_type(span) + 1;
+        }
+
+        auto slot_of(key_type key) -> slot*
+        {
+            auto i = offset(key, lowest);
+            return (i < table.size() ? &table[i] : nullptr);
+        }
+
+        // Where the list position of key is kept, or nullptr if key isn't in.
+        auto locate(key_type key) const -> list_iterator const*
+        {
+            auto i = offset(key, lowest);
+            if (i < table.size())
+                return (table[i].used ? &table[i].at : nullptr);
+
+            auto map_it = map.find(key);
+            return (map_it == map.end() ? nullptr : &map_it->second);
+        }
+
+        template <class... Args>
+        auto insert_at(list_iterator where, Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto s = slot_of(value.first);
+            if (s) {
+                if (s->used) return { s->at, false };
+                s->at = list.insert(where, std::move(value));
+                s->used = true;
+                return { s->at, true };
+            }
+
+            auto map_it = map.find(value.first);
+            if (map_it != map.end())
+                return { map_it->second, false };
+
+            auto list_it = list.insert(where, std::move(value));
+            map.emplace(list_it->first, list_it);
+            return { list_it, true };
+        }
+
+        key_type lowest{};
+        // one slot per key in range
+        std::vector<slot> table;
+        // keys out of range
+        map_type map;
+        list_type list;
+    };
+}
@@ -0,0 +1,215 @@
+#pragma once
+// A string interner that numbers strings in insertion-order,
+// for C++17 or above.
+//
+// Each distinct string gets a dense 32-bit id: its position in insertion-order,
+// so the first one interned is 0, the next new one is 1, and so on. Strings
+// never leave, so ids never change. Both ways are O(1):
+// string -> id through a hash index of positions, and id -> string by
+// indexing a contiguous array of `std::string_view`s into an arena.
+//
+// Once `freeze()`d, it's read-only: any number of threads may look up
+// concurrently, as nothing, not even `intern` of a known string, writes.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "detail/position-index.hpp"
+#include "detail/string-arena.hpp"
+#include <string_view>
+#include <vector>
+#include <iterator>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdint>
+
+namespace nonstd
+{
+    template <
+        class Hash = std::hash<std::string_view>
+        , class Equal = std::equal_to<std::string_view>
+    >
+    struct fifo_interner final
+    {
+        using id_type = std::uint32_t;
+        using hasher = Hash;
+        using equal = Equal;
+
+        using index_type = fifo_detail::position_index;
+        using size_type = typename index_type::size_type;
+        using const_iterator = typename std::vector<std::string_view>::const_iterator;
+
+        static constexpr id_type npos = id_type(-1);
+
+        // rule of five; copies get their own arena
+        fifo_interner() = default;
+
+        fifo_interner(fifo_interner const& x)
+        {
+            reserve(x.size());
+            for (auto s: x)
+                intern(s);
+            frozen = x.frozen;
+        }
+
+        auto operator = (fifo_interner const& x) -> fifo_interner&
+        {
+            if (this != &x) {
+                clear();
+                reserve(x.size());
+                for (auto s: x)
+                    intern(s);
+                frozen = x.frozen;
+            }
+            return *this;
+        }
+
+        fifo_interner(fifo_interner&&) noexcept = default;
+        auto operator = (fifo_interner&&) noexcept -> fifo_interner& = default;
+
+        // The id of s, interning it first if it's new.
+        // Throws std::logic_error for a new string once frozen.
+        auto intern(std::string_view s) -> id_type
+        {
+            return intern(hash_of(s), s);
+        }
+
+        // Interns a batch, writing their ids to out, in order.
+        // Over forward iterators to strings that stay put, strings are
+        // hashed a block at a time before any of them is looked up;
+        // anything else, such as `std::istream_iterator`, is interned
+        // one element at a time, before the iterator moves on.
+        template <class Input_Iterator, class Output_Iterator>
+        auto intern_all(Input_Iterator first, Input_Iterator last, Output_Iterator out) -> Output_Iterator
+        {
+            using traits = std::iterator_traits<Input_Iterator>;
+            constexpr bool stable = std::is_base_of_v<std::forward_iterator_tag, typename traits::iterator_category>
+                && std::is_lvalue_reference_v<typename traits::reference>;
+
+            if constexpr (!stable) {
+                for (; first != last; ++first)
+                    *out++ = intern(*first);
+                return out;
+            } else {
+                if (!frozen) reserve(size() + size_type(std::distance(first, last)));
+
+                constexpr std::size_t block = 32;
+                std::string_view views[block];
+                std::size_t hashes[block];
+
+                while (first != last) {
+                    std::size_t n = 0;
+                    for (; n < block && first != last; ++n, ++first) {
+                        views[n] = *first;
+                        hashes[n] = hash_of(views[n]);
+                    }
+                    for (std::size_t i = 0; i < n; ++i)
+                        *out++ = intern(hashes[i], views[i]);
+                }
+                return out;
+            }
+        }
+
+        // The id of s, or npos if it was never interned.
+        auto find(std::string_view s) const -> id_type
+        {
+            return find(hash_of(s), s);
+        }
+
+        auto count(std::string_view s) const -> size_type
+        {
+            return (find(s) == npos ? 0 : 1);
+        }
+
+        // The string with this id, which must have been handed out.
+        auto operator [] (id_type id) const -> std::string_view
+        {
+            return strings[id];
+        }
+
+        auto at(id_type id) const -> std::string_view
+        {
+            if (id >= strings.size()) throw std::out_of_range{"fifo_interner::at"};
+            return strings[id];
+        }
+
+        // No new strings from now on, and no writes at all,
+        // so it can be shared by concurrent readers.
+        auto freeze() -> void
+        {
+            strings.shrink_to_fit();
+            frozen = true;
+        }
+
+        auto is_frozen() const -> bool
+        {
+            return frozen;
+        }
+
+        auto clear() -> void
+        {
+            index.clear();
+            strings.clear();
+            arena.clear();
+            frozen = false;
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            index.reserve(n);
+            strings.reserve(n);
+        }
+
+        auto size() const -> size_type
+        {
+            return strings.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return strings.empty();
+        }
+
+        // The interned strings in id order.
+        auto begin() const -> const_iterator { return strings.begin(); }
+        auto   end() const -> const_iterator { return strings.  end(); }
+        auto cbegin() const -> const_iterator { return strings.cbegin(); }
+        auto   cend() const -> const_iterator { return strings.  cend(); }
+
+    private:
+        static auto hash_of(std::string_view s) -> std::size_t
+        {
+            hasher h{};
+            return h(s);
+        }
+
+        auto find(std::size_t hash, std::string_view s) const -> id_type
+        {
+            equal eq{};
+            auto position = index.find(hash, [&] (size_type position) {
+                return eq(strings[position], s);
+            });
+            return (position == index_type::npos ? npos : id_type(position));
+        }
+
+        auto intern(std::size_t hash, std::string_view s) -> id_type
+        {
+            auto id = find(hash, s);
+            if (id != npos) return id;
+
+            if (frozen) throw std::logic_error{"fifo_interner::intern: frozen"};
+            if (strings.size() >= npos) throw std::length_error{"fifo_interner::intern: out of ids"};
+
+            index.reserve(size() + 1);
+            strings.push_back(arena.store(s));
+            index.insert(hash, strings.size() - 1);
+            return id_type(strings.size() - 1);
+        }
+
+        index_type index;
+        // id -> string
+        std::vector<std::string_view> strings;
+        fifo_detail::string_arena arena;
+        bool frozen{};
+    };
+}
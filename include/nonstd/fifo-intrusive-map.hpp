@@ -0,0 +1,403 @@
+#pragma once
+// Intrusive hash containers that guarantee iteration in insertion-order,
+// for C++14 or above.
+//
+// The objects carry their own links: embed a `fifo_intrusive_hook<T>` in T
+// and hand the container references to objects you already own, say in a
+// slab or a pool. The container allocates nothing per entry; all it owns is
+// its bucket array. Each hook links its object into both the insertion-order
+// list and a hash chain, and caches the hash.
+//
+// `fifo_intrusive_map` looks objects up by a key that `Key_Of` reads out of
+// them; `fifo_intrusive_set` looks them up by the whole object.
+//
+// The container never destroys or frees objects. An object must outlive its
+// membership and must not move while linked; its key must not change either.
+// Copying an object doesn't copy its membership.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <iterator>
+#include <functional>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+namespace nonstd
+{
+    template <class T>
+    struct fifo_intrusive_hook final
+    {
+        fifo_intrusive_hook() = default;
+        fifo_intrusive_hook(fifo_intrusive_hook const&) noexcept {}
+        auto operator = (fifo_intrusive_hook const&) noexcept -> fifo_intrusive_hook& { return *this; }
+
+        auto is_linked() const -> bool
+        {
+            return linked;
+        }
+
+    private:
+        template <class U, fifo_intrusive_hook<U> U::*, class, class, class>
+        friend struct fifo_intrusive_map;
+
+        // neighbors in insertion-order
+        T* prev{};
+        T* next{};
+        // next in the same bucket
+        T* chain{};
+        std::size_t hash{};
+        bool linked{};
+    };
+
+    namespace fifo_detail
+    {
+        template <class T>
+        struct identity_key final
+        {
+            auto operator () (T const& x) const -> T const&
+            {
+                return x;
+            }
+        };
+
+        template <class T, class Key_Of>
+        using intrusive_key_t = std::decay_t<decltype(std::declval<Key_Of const&>()(std::declval<T const&>()))>;
+    }
+
+    template <
+        class T
+        , fifo_intrusive_hook<T> T::* Hook
+        , class Key_Of
+        , class Hash = std::hash<fifo_detail::intrusive_key_t<T, Key_Of>>
+        , class Key_Equal = std::equal_to<fifo_detail::intrusive_key_t<T, Key_Of>>
+    >
+    struct fifo_intrusive_map final
+    {
+        using key_type = fifo_detail::intrusive_key_t<T, Key_Of>;
+        using value_type = T;
+        using key_of = Key_Of;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+        using size_type = std::size_t;
+
+        template <bool Const>
+        struct basic_iterator final
+        {
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = fifo_intrusive_map::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, value_type const*, value_type*>;
+            using reference = std::conditional_t<Const, value_type const&, value_type&>;
+
+            basic_iterator() = default;
+
+            // iterator -> const_iterator
+            template <bool Other, class = std::enable_if_t<Const && !Other>>
+            basic_iterator(basic_iterator<Other> const& x): owner{x.owner}, at{x.at} {}
+
+            auto operator *  () const -> reference { return *at; }
+            auto operator -> () const -> pointer { return at; }
+
+            auto operator ++ () -> basic_iterator& { at = (at->*Hook).next; return *this; }
+            auto operator -- () -> basic_iterator& { at = (at ? (at->*Hook).prev : owner->tail); return *this; }
+            auto operator ++ (int) -> basic_iterator { auto x = *this; ++*this; return x; }
+            auto operator -- (int) -> basic_iterator { auto x = *this; --*this; return x; }
+
+            friend auto operator == (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at == b.at; }
+            friend auto operator != (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at != b.at; }
+
+        private:
+            friend fifo_intrusive_map;
+            template <bool> friend struct basic_iterator;
+            basic_iterator(fifo_intrusive_map const* owner, T* at): owner{owner}, at{at} {}
+
+            // for --end()
+            fifo_intrusive_map const* owner{};
+            T* at{};
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        // Like Boost.Intrusive containers, there's no copying;
+        // an object can only be linked into one container per hook.
+        fifo_intrusive_map() = default;
+        fifo_intrusive_map(fifo_intrusive_map const&) = delete;
+        auto operator = (fifo_intrusive_map const&) -> fifo_intrusive_map& = delete;
+
+        fifo_intrusive_map(fifo_intrusive_map&& other) noexcept
+        {
+            take(other);
+        }
+
+        auto operator = (fifo_intrusive_map&& other) noexcept -> fifo_intrusive_map&
+        {
+            if (this != &other) {
+                clear();
+                take(other);
+            }
+            return *this;
+        }
+
+        // Unlinks every object, so none is left pointing at a dead container.
+        ~fifo_intrusive_map()
+        {
+            clear();
+        }
+
+        // For interface compatibility with std::unordered_set.
+        auto insert(T& x) -> std::pair<iterator, bool>
+        {
+            return push_back(x);
+        }
+
+        // Links x in last, unless an object with the same key is linked already.
+        // x must not be linked.
+        auto push_back(T& x) -> std::pair<iterator, bool>
+        {
+            auto&& hook = x.*Hook;
+            assert(!hook.linked);
+
+            hook.hash = hash_of(key_of{}(x));
+            if (auto found = find_in_bucket(hook.hash, key_of{}(x)))
+                return { make_iterator(found), false };
+
+            link_bucket(x);
+            hook.prev = tail;
+            hook.next = nullptr;
+            (tail ? (tail->*Hook).next : head) = &x;
+            tail = &x;
+            return { make_iterator(&x), true };
+        }
+
+        auto push_front(T& x) -> std::pair<iterator, bool>
+        {
+            auto&& hook = x.*Hook;
+            assert(!hook.linked);
+
+            hook.hash = hash_of(key_of{}(x));
+            if (auto found = find_in_bucket(hook.hash, key_of{}(x)))
+                return { make_iterator(found), false };
+
+            link_bucket(x);
+            hook.prev = nullptr;
+            hook.next = head;
+            (head ? (head->*Hook).prev : tail) = &x;
+            head = &x;
+            return { make_iterator(&x), true };
+        }
+
+        // Unlinks it; the object itself is left alone.
+        // To unlink an object you hold, `erase(iterator_to(x))`.
+        auto erase(const_iterator it) -> iterator
+        {
+            auto x = it.at;
+            auto next = (x->*Hook).next;
+            unlink(*x);
+            return make_iterator(next);
+        }
+
+        auto erase(key_type const& key) -> size_type
+        {
+            auto found = find_in_bucket(hash_of(key), key);
+            if (!found) return 0;
+            unlink(*found);
+            return 1;
+        }
+
+        // Unlinks every object; keeps the bucket array.
+        auto clear() -> void
+        {
+            for (auto x = head; x; ) {
+                auto&& hook = x->*Hook;
+                auto next = hook.next;
+                hook.prev = hook.next = hook.chain = nullptr;
+                hook.linked = false;
+                x = next;
+            }
+            for (auto&& b: buckets)
+                b = nullptr;
+            head = tail = nullptr;
+            count_all = 0;
+        }
+
+        // The only allocation the container makes.
+        auto reserve(size_type n) -> void
+        {
+            if (n <= buckets.size()) return;
+
+            size_type capacity = 8;
+            while (capacity < n) capacity <<= 1;
+            rehash(capacity);
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            return (find_in_bucket(hash_of(key), key) ? 1 : 0);
+        }
+
+        auto size() const -> size_type
+        {
+            return count_all;
+        }
+
+        auto empty() const -> bool
+        {
+            return (count_all == 0);
+        }
+
+        auto find(key_type const& key) const -> const_iterator
+        {
+            return make_iterator(find_in_bucket(hash_of(key), key));
+        }
+
+        auto find(key_type const& key) -> iterator
+        {
+            return make_iterator(find_in_bucket(hash_of(key), key));
+        }
+
+        // An iterator to x, which must be linked into this container.
+        auto iterator_to(T& x) -> iterator
+        {
+            return make_iterator(&x);
+        }
+
+        auto iterator_to(T const& x) const -> const_iterator
+        {
+            return make_iterator(const_cast<T*>(&x));
+        }
+
+        auto begin() -> iterator { return make_iterator(head); }
+        auto   end() -> iterator { return make_iterator(nullptr); }
+        auto begin() const -> const_iterator { return make_iterator(head); }
+        auto   end() const -> const_iterator { return make_iterator(nullptr); }
+        auto cbegin() const -> const_iterator { return begin(); }
+        auto   cend() const -> const_iterator { return end(); }
+        auto rbegin() -> reverse_iterator { return reverse_iterator{end()}; }
+        auto   rend() -> reverse_iterator { return reverse_iterator{begin()}; }
+        auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+        auto   rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+
+        // Oldest and newest objects; the container must not be empty.
+        auto front() -> T& { return *head; }
+        auto  back() -> T& { return *tail; }
+        auto front() const -> T const& { return *head; }
+        auto  back() const -> T const& { return *tail; }
+
+    private:
+        static auto hash_of(key_type const& key) -> std::size_t
+        {
+            hasher h{};
+            return h(key);
+        }
+
+        auto make_iterator(T* x) -> iterator
+        {
+            return { this, x };
+        }
+
+        auto make_iterator(T* x) const -> const_iterator
+        {
+            return { this, x };
+        }
+
+        // Fibonacci hashing; std::hash of integers is usually the identity.
+        auto bucket_of(std::size_t hash) const -> size_type
+        {
+            return size_type((std::uint64_t(hash) * 0x9E3779B97F4A7C15ull) >> shift);
+        }
+
+        auto find_in_bucket(std::size_t hash, key_type const& key) const -> T*
+        {
+            if (buckets.empty()) return nullptr;
+
+            key_equal eq{};
+            for (auto x = buckets[bucket_of(hash)]; x; x = (x->*Hook).chain)
+                if ((x->*Hook).hash == hash && eq(key_of{}(*x), key))
+                    return x;
+            return nullptr;
+        }
+
+        // Load factor stays at or below 1.
+        auto link_bucket(T& x) -> void
+        {
+            reserve(count_all + 1);
+
+            auto&& hook = x.*Hook;
+            auto&& b = buckets[bucket_of(hook.hash)];
+            hook.chain = b;
+            hook.linked = true;
+            b = &x;
+            ++count_all;
+        }
+
+        auto unlink(T& x) -> void
+        {
+            auto&& hook = x.*Hook;
+            assert(hook.linked);
+
+            auto at = &buckets[bucket_of(hook.hash)];
+            while (*at != &x)
+                at = &((*at)->*Hook).chain;
+            *at = hook.chain;
+
+            (hook.prev ? (hook.prev->*Hook).next : head) = hook.next;
+            (hook.next ? (hook.next->*Hook).prev : tail) = hook.prev;
+
+            hook.prev = hook.next = hook.chain = nullptr;
+            hook.linked = false;
+            --count_all;
+        }
+
+        auto rehash(size_type capacity) -> void
+        {
+            buckets.assign(capacity, nullptr);
+
+            shift = 64;
+            while (capacity >>= 1) --shift;
+
+            for (auto x = head; x; x = (x->*Hook).next) {
+                auto&& hook = x->*Hook;
+                auto&& b = buckets[bucket_of(hook.hash)];
+                hook.chain = b;
+                b = x;
+            }
+        }
+
+        auto take(fifo_intrusive_map& other) -> void
+        {
+            buckets = std::move(other.buckets);
+            head = other.head;
+            tail = other.tail;
+            count_all = other.count_all;
+            shift = other.shift;
+
+            other.buckets.clear();
+            other.head = other.tail = nullptr;
+            other.count_all = 0;
+            other.shift = 64;
+        }
+
+        std::vector<T*> buckets;
+        // ends of the insertion-order list
+        T* head{};
+        T* tail{};
+        size_type count_all{};
+        // 64 - log2(bucket count)
+        unsigned shift{64};
+    };
+
+    template <
+        class T
+        , fifo_intrusive_hook<T> T::* Hook
+        , class Hash = std::hash<T>
+        , class Equal = std::equal_to<T>
+    >
+    using fifo_intrusive_set = fifo_intrusive_map<T, Hook, fifo_detail::identity_key<T>, Hash, Equal>;
+}
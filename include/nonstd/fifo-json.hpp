@@ -0,0 +1,612 @@
+#pragma once
+// A JSON reader whose objects keep their members in document order,
+// for C++14 or above.
+//
+// `fifo_json_read` is SAX-style: it walks the text and calls a handler
+// for every value, key and bracket. `fifo_json::parse` is that plus
+// `fifo_json_builder`, building a `fifo_json` tree whose objects are
+// `fifo_map<std::string, fifo_json>`.
+//
+// Before parsing, one quick pass over the structural characters counts the
+// members of every object, and handlers get the count in `begin_object`,
+// so the builder can reserve each object's index once. Keys are moved into
+// place. On duplicate keys the first one wins, as with `emplace_back`;
+// later values for it are parsed and dropped.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-map.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <deque>
+#include <stdexcept>
+#include <cstdlib>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+namespace nonstd
+{
+    // Bad JSON; offset is where in the text it was found.
+    struct fifo_json_error final: std::runtime_error
+    {
+        fifo_json_error(char const* what, std::size_t offset)
+            : std::runtime_error{what}
+            , at{offset}
+        {}
+
+        auto offset() const -> std::size_t
+        {
+            return at;
+        }
+
+    private:
+        std::size_t at;
+    };
+
+    namespace fifo_detail
+    {
+        inline auto is_json_space(char c) -> bool
+        {
+            return (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+        }
+
+        // JSON's decimal point is always '.', strtod's and printf's are the
+        // current C locale's; replaces every from in text with to.
+        inline auto swap_decimal_point(std::string& text, char const* from, char const* to) -> void
+        {
+            auto from_size = std::strlen(from);
+            if (std::strcmp(from, to) == 0 || from_size == 0) return;
+            for (auto at = text.find(from); at != std::string::npos; at = text.find(from, at + std::strlen(to)))
+                text.replace(at, from_size, to);
+        }
+
+        // The structural pass: the member count of every object,
+        // in the order their '{'s appear. Only a hint for reserving,
+        // so it doesn't validate anything.
+        inline auto count_json_members(char const* first, char const* last) -> std::vector<std::uint32_t>
+        {
+            struct open final
+            {
+                std::size_t object;     // index into counts, or npos for arrays
+                bool any;
+            };
+            constexpr auto npos = std::size_t(-1);
+
+            std::vector<std::uint32_t> counts;
+            std::vector<open> stack;
+
+            for (auto p = first; p != last; ++p) {
+                switch (*p) {
+                    case '"':
+                        if (!stack.empty()) stack.back().any = true;
+                        for (++p; p != last && *p != '"'; ++p)
+                            if (*p == '\\' && p + 1 != last) ++p;
+                        if (p == last) return counts;
+                        break;
+                    case '{':
+                        stack.push_back({ counts.size(), false });
+                        counts.push_back(0);
+                        break;
+                    case '[':
+                        stack.push_back({ npos, false });
+                        break;
+                    case ',':
+                        if (!stack.empty() && stack.back().object != npos)
+                            ++counts[stack.back().object];
+                        break;
+                    case '}':
+                    case ']':
+                        if (stack.empty()) return counts;
+                        if (stack.back().object != npos)
+                            counts[stack.back().object] += (stack.back().any ? 1 : 0);
+                        stack.pop_back();
+                        break;
+                    default:
+                        break;
+                }
+            }
+            return counts;
+        }
+
+        template <class Handler>
+        struct json_reader final
+        {
+            json_reader(char const* first, char const* last, Handler& handler)
+                : first{first}
+                , p{first}
+                , last{last}
+                , handler{handler}
+                , counts{count_json_members(first, last)}
+            {}
+
+            auto read() -> void
+            {
+                skip_space();
+                value(0);
+                skip_space();
+                if (p != last) fail("fifo_json: trailing characters");
+            }
+
+        private:
+            static constexpr int max_depth = 512;
+
+            [[noreturn]] auto fail(char const* what) const -> void
+            {
+                throw fifo_json_error{what, std::size_t(p - first)};
+            }
+
+            auto skip_space() -> void
+            {
+                while (p != last && is_json_space(*p)) ++p;
+            }
+
+            auto expect(char c) -> void
+            {
+                skip_space();
+                if (p == last || *p != c) fail("fifo_json: unexpected character");
+                ++p;
+            }
+
+            auto literal(char const* word, std::size_t n) -> void
+            {
+                if (std::size_t(last - p) < n || std::memcmp(p, word, n)) fail("fifo_json: bad literal");
+                p += n;
+            }
+
+            auto value(int depth) -> void
+            {
+                if (depth > max_depth) fail("fifo_json: nested too deep");
+                if (p == last) fail("fifo_json: unexpected end");
+
+                switch (*p) {
+                    case '{': object(depth); break;
+                    case '[': array(depth); break;
+                    case '"': handler.string(string()); break;
+                    case 't': literal("true", 4); handler.boolean(true); break;
+                    case 'f': literal("false", 5); handler.boolean(false); break;
+                    case 'n': literal("null", 4); handler.null(); break;
+                    default: handler.number(number()); break;
+                }
+            }
+
+            auto object(int depth) -> void
+            {
+                ++p;
+                handler.begin_object(next_object < counts.size() ? counts[next_object] : 0);
+                ++next_object;
+
+                skip_space();
+                if (p != last && *p == '}') {
+                    ++p;
+                    handler.end_object();
+                    return;
+                }
+
+                for (;;) {
+                    skip_space();
+                    if (p == last || *p != '"') fail("fifo_json: expected a key");
+                    handler.key(string());
+                    expect(':');
+                    skip_space();
+                    value(depth + 1);
+                    skip_space();
+                    if (p == last) fail("fifo_json: unexpected end");
+                    if (*p == '}') break;
+                    if (*p != ',') fail("fifo_json: expected ',' or '}'");
+                    ++p;
+                }
+                ++p;
+                handler.end_object();
+            }
+
+            auto array(int depth) -> void
+            {
+                ++p;
+                handler.begin_array();
+
+                skip_space();
+                if (p != last && *p == ']') {
+                    ++p;
+                    handler.end_array();
+                    return;
+                }
+
+                for (;;) {
+                    skip_space();
+                    value(depth + 1);
+                    skip_space();
+                    if (p == last) fail("fifo_json: unexpected end");
+                    if (*p == ']') break;
+                    if (*p != ',') fail("fifo_json: expected ',' or ']'");
+                    ++p;
+                }
+                ++p;
+                handler.end_array();
+            }
+
+            auto string() -> std::string
+            {
+                ++p;
+                auto start = p;
+                while (p != last && *p != '"' && *p != '\\') {
+                    if (static_cast<unsigned char>(*p) < 0x20) fail("fifo_json: control character in string");
+                    ++p;
+                }
+                if (p == last) fail("fifo_json: unterminated string");
+
+                std::string s(start, p);
+                while (*p != '"') {
+                    if (*p == '\\') {
+                        escape(s);
+                    } else {
+                        if (static_cast<unsigned char>(*p) < 0x20) fail("fifo_json: control character in string");
+                        s += *p++;
+                    }
+                    if (p == last) fail("fifo_json: unterminated string");
+                }
+                ++p;
+                return s;
+            }
+
+            auto escape(std::string& s) -> void
+            {
+                if (++p == last) fail("fifo_json: unterminated string");
+                switch (*p++) {
+                    case '"': s += '"'; break;
+                    case '\\': s += '\\'; break;
+                    case '/': s += '/'; break;
+                    case 'b': s += '\b'; break;
+                    case 'f': s += '\f'; break;
+                    case 'n': s += '\n'; break;
+                    case 'r': s += '\r'; break;
+                    case 't': s += '\t'; break;
+                    case 'u': {
+                        auto c = hex4();
+                        if (c >= 0xD800 && c < 0xDC00) {
+                            if (last - p < 2 || p[0] != '\\' || p[1] != 'u') fail("fifo_json: lone surrogate");
+                            p += 2;
+                            auto low = hex4();
+                            if (low < 0xDC00 || low >= 0xE000) fail("fifo_json: lone surrogate");
+                            c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                        } else if (c >= 0xDC00 && c < 0xE000) {
+                            fail("fifo_json: lone surrogate");
+                        }
+                        utf8(s, c);
+                        break;
+                    }
+                    default: --p; fail("fifo_json: bad escape");
+                }
+            }
+
+            auto hex4() -> std::uint32_t
+            {
+                if (last - p < 4) fail("fifo_json: bad escape");
+                std::uint32_t c = 0;
+                for (auto i = 0; i < 4; ++i, ++p) {
+                    c <<= 4;
+                    if (*p >= '0' && *p <= '9') c |= std::uint32_t(*p - '0');
+                    else if (*p >= 'a' && *p <= 'f') c |= std::uint32_t(*p - 'a' + 10);
+                    else if (*p >= 'A' && *p <= 'F') c |= std::uint32_t(*p - 'A' + 10);
+                    else fail("fifo_json: bad escape");
+                }
+                return c;
+            }
+
+            static auto utf8(std::string& s, std::uint32_t c) -> void
+            {
+                if (c < 0x80) {
+                    s += char(c);
+                } else if (c < 0x800) {
+                    s += char(0xC0 | (c >> 6));
+                    s += char(0x80 | (c & 0x3F));
+                } else if (c < 0x10000) {
+                    s += char(0xE0 | (c >> 12));
+                    s += char(0x80 | ((c >> 6) & 0x3F));
+                    s += char(0x80 | (c & 0x3F));
+                } else {
+                    s += char(0xF0 | (c >> 18));
+                    s += char(0x80 | ((c >> 12) & 0x3F));
+                    s += char(0x80 | ((c >> 6) & 0x3F));
+                    s += char(0x80 | (c & 0x3F));
+                }
+            }
+
+            // Checks the grammar, then leaves the conversion to strtod.
+            auto number() -> double
+            {
+                auto start = p;
+                auto digits = [&] {
+                    auto from = p;
+                    while (p != last && *p >= '0' && *p <= '9') ++p;
+                    return (p != from);
+                };
+
+                if (p != last && *p == '-') ++p;
+                if (p != last && *p == '0') ++p;
+                else if (!digits()) fail("fifo_json: unexpected character");
+                if (p != last && *p == '.') {
+                    ++p;
+                    if (!digits()) fail("fifo_json: bad number");
+                }
+                if (p != last && (*p == 'e' || *p == 'E')) {
+                    ++p;
+                    if (p != last && (*p == '+' || *p == '-')) ++p;
+                    if (!digits()) fail("fifo_json: bad number");
+                }
+
+                // strtod wants a terminated string, in its locale's format
+                std::string text(start, p);
+                swap_decimal_point(text, ".", std::localeconv()->decimal_point);
+                return std::strtod(text.c_str(), nullptr);
+            }
+
+            char const* first;
+            char const* p;
+            char const* last;
+            Handler& handler;
+            std::vector<std::uint32_t> counts;
+            std::size_t next_object{};
+        };
+    }
+
+    // Calls handler.null(), .boolean(bool), .number(double),
+    // .string(std::string&&), .begin_array(), .end_array(),
+    // .begin_object(members), .key(std::string&&) and .end_object()
+    // as it reads the text. Throws fifo_json_error on bad JSON.
+    template <class Handler>
+    auto fifo_json_read(char const* first, char const* last, Handler& handler) -> void
+    {
+        fifo_detail::json_reader<Handler>{first, last, handler}.read();
+    }
+
+    struct fifo_json final
+    {
+        enum class kind
+        {
+            null,
+            boolean,
+            number,
+            string,
+            array,
+            object,
+        };
+
+        using array_type = std::vector<fifo_json>;
+        using object_type = fifo_map<std::string, fifo_json>;
+
+        static auto parse(char const* first, char const* last) -> fifo_json;
+        static auto parse(std::string const& text) -> fifo_json
+        {
+            return parse(text.data(), text.data() + text.size());
+        }
+
+        fifo_json() = default;
+        fifo_json(std::nullptr_t) {}
+        fifo_json(bool b): type{kind::boolean}, boolean{b} {}
+        fifo_json(double n): type{kind::number}, number{n} {}
+        fifo_json(int n): fifo_json{double(n)} {}
+        fifo_json(char const* s): fifo_json{std::string{s}} {}
+        fifo_json(std::string s): type{kind::string}, string{std::move(s)} {}
+        fifo_json(array_type a): type{kind::array}, array{new array_type(std::move(a))} {}
+        fifo_json(object_type o): type{kind::object}, object{new object_type(std::move(o))} {}
+
+        // rule of five; copies are deep
+        fifo_json(fifo_json const& x)
+            : type{x.type}
+            , boolean{x.boolean}
+            , number{x.number}
+            , string{x.string}
+            , array{x.array ? new array_type(*x.array) : nullptr}
+            , object{x.object ? new object_type(*x.object) : nullptr}
+        {}
+
+        auto operator = (fifo_json const& x) -> fifo_json&
+        {
+            if (this != &x) *this = fifo_json{x};
+            return *this;
+        }
+
+        fifo_json(fifo_json&&) noexcept = default;
+        auto operator = (fifo_json&&) noexcept -> fifo_json& = default;
+
+        auto get_kind() const -> kind { return type; }
+        auto is_null() const -> bool { return type == kind::null; }
+        auto is_boolean() const -> bool { return type == kind::boolean; }
+        auto is_number() const -> bool { return type == kind::number; }
+        auto is_string() const -> bool { return type == kind::string; }
+        auto is_array() const -> bool { return type == kind::array; }
+        auto is_object() const -> bool { return type == kind::object; }
+
+        // Throw std::logic_error if it's something else.
+        auto as_boolean() const -> bool { check(kind::boolean); return boolean; }
+        auto as_number() const -> double { check(kind::number); return number; }
+        auto as_string() const -> std::string const& { check(kind::string); return string; }
+        auto as_string() -> std::string& { check(kind::string); return string; }
+        auto as_array() const -> array_type const& { check(kind::array); return *array; }
+        auto as_array() -> array_type& { check(kind::array); return *array; }
+        auto as_object() const -> object_type const& { check(kind::object); return *object; }
+        auto as_object() -> object_type& { check(kind::object); return *object; }
+
+        // Members in document order. Throws std::domain_error on inf and
+        // nan, which JSON can't write (1e999 parses to inf).
+        auto dump() const -> std::string
+        {
+            std::string out;
+            dump(out);
+            return out;
+        }
+
+    private:
+        auto check(kind k) const -> void
+        {
+            if (type != k) throw std::logic_error{"fifo_json: wrong kind"};
+        }
+
+        auto dump(std::string& out) const -> void
+        {
+            switch (type) {
+                case kind::null: out += "null"; break;
+                case kind::boolean: out += (boolean ? "true" : "false"); break;
+                case kind::number: {
+                    // JSON has no inf or nan
+                    if (!std::isfinite(number)) throw std::domain_error{"fifo_json: non-finite number"};
+                    char buffer[32];
+                    std::snprintf(buffer, sizeof(buffer), "%.17g", number);
+                    std::string text = buffer;
+                    fifo_detail::swap_decimal_point(text, std::localeconv()->decimal_point, ".");
+                    out += text;
+                    break;
+                }
+                case kind::string: dump_string(out, string); break;
+                case kind::array: {
+                    out += '[';
+                    auto comma = false;
+                    for (auto&& x: *array) {
+                        if (comma) out += ',';
+                        x.dump(out);
+                        comma = true;
+                    }
+                    out += ']';
+                    break;
+                }
+                case kind::object: {
+                    out += '{';
+                    auto comma = false;
+                    for (auto&& kv: *object) {
+                        if (comma) out += ',';
+                        dump_string(out, kv.first);
+                        out += ':';
+                        kv.second.dump(out);
+                        comma = true;
+                    }
+                    out += '}';
+                    break;
+                }
+            }
+        }
+
+        static auto dump_string(std::string& out, std::string const& s) -> void
+        {
+            out += '"';
+            for (auto c: s) {
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char buffer[8];
+                            std::snprintf(buffer, sizeof(buffer), "\\u%04x", unsigned(c));
+                            out += buffer;
+                        } else {
+                            out += c;
+                        }
+                }
+            }
+            out += '"';
+        }
+
+        kind type{kind::null};
+        bool boolean{};
+        double number{};
+        std::string string;
+        std::unique_ptr<array_type> array;
+        std::unique_ptr<object_type> object;
+    };
+
+    // A fifo_json_read handler that builds a fifo_json.
+    struct fifo_json_builder final
+    {
+        auto null() -> void { put(fifo_json{}); }
+        auto boolean(bool b) -> void { put(fifo_json{b}); }
+        auto number(double n) -> void { put(fifo_json{n}); }
+        auto string(std::string&& s) -> void { put(fifo_json{std::move(s)}); }
+
+        auto begin_array() -> void
+        {
+            open(put(fifo_json{fifo_json::array_type{}}));
+        }
+
+        auto end_array() -> void
+        {
+            stack.pop_back();
+        }
+
+        auto begin_object(std::size_t members) -> void
+        {
+            auto&& x = put(fifo_json{fifo_json::object_type{}});
+            x.as_object().reserve(members);
+            open(x);
+        }
+
+        // The first of duplicate keys wins; later values go to a scratch
+        // slot, one per depth, as a dropped value may have duplicates too.
+        auto key(std::string&& k) -> void
+        {
+            auto r = stack.back().value->as_object().emplace_back(std::move(k), fifo_json{});
+            if (r.second) {
+                stack.back().member = &r.first->second;
+            } else {
+                while (dropped.size() < stack.size()) dropped.emplace_back();
+                stack.back().member = &dropped[stack.size() - 1];
+            }
+        }
+
+        auto end_object() -> void
+        {
+            stack.pop_back();
+        }
+
+        auto result() -> fifo_json&
+        {
+            return root;
+        }
+
+    private:
+        struct frame final
+        {
+            fifo_json* value;
+            // where the value after the current key goes
+            fifo_json* member;
+        };
+
+        auto put(fifo_json&& x) -> fifo_json&
+        {
+            if (stack.empty()) return (root = std::move(x));
+
+            auto&& top = stack.back();
+            if (top.value->is_array()) {
+                auto&& a = top.value->as_array();
+                a.push_back(std::move(x));
+                return a.back();
+            }
+            return (*top.member = std::move(x));
+        }
+
+        // Arrays and objects stay where they are while their members are read:
+        // array elements are only appended to the innermost array.
+        auto open(fifo_json& x) -> void
+        {
+            stack.push_back({ &x, nullptr });
+        }
+
+        fifo_json root;
+        // deque, so slots don't move as it grows
+        std::deque<fifo_json> dropped;
+        std::vector<frame> stack;
+    };
+
+    inline auto fifo_json::parse(char const* first, char const* last) -> fifo_json
+    {
+        fifo_json_builder builder;
+        fifo_json_read(first, last, builder);
+        return std::move(builder.result());
+    }
+}
@@ -0,0 +1,268 @@
+#pragma once
+// How `fifo_map` and `fifo_set` refer to their keys from the lookup index,
+// for C++14 or above.
+//
+// The index is an `std::unordered_map` keyed by a reference to the key
+// stored in the list node, so by default every probe that lands on a
+// candidate follows the reference into the node to compare.
+//
+// For `std::string` (and `std::string_view`) keys compared with
+// `std::equal_to`, the reference also carries the hash, the length
+// and the first 8 bytes of the key, "German string" style.
+// Most mismatches are then rejected without touching the node or the
+// string's heap buffer, and rehashing doesn't touch them at all.
+//
+// Fixed-width keys of up to 32 bytes, like 16-byte UUIDs in
+// `std::array<std::uint8_t, 16>`, are copied into the reference whole and
+// compared by their bytes, which compiles to a couple of vector compares;
+// probes don't touch the node at all. `fifo_fixed_width_hash` is a
+// matching hasher for them.
+//
+// Containers that look values up by a key inside them take a `Key_Of`;
+// `fifo_member_key` makes one out of a data member. They refer to keys with
+// `fifo_member_key_reference`, which points at fixed-width keys instead of
+// copying them, so those records still hold the only copy of their key.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include <string>
+#include <array>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#endif
+
+namespace nonstd
+{
+    // Key_Of for a data member: `fifo_member_key<Record, Id, &Record::id>`.
+    template <class T, class Key, Key T::* Member>
+    struct fifo_member_key final
+    {
+        auto operator () (T const& x) const -> Key const&
+        {
+            return x.*Member;
+        }
+    };
+
+    // Keys whose equality is exactly the equality of their bytes.
+    // Specialize it for your own trivially copyable key types without padding.
+    template <class Key>
+    struct fifo_is_fixed_width_key: std::false_type {};
+
+    template <class T, std::size_t N>
+    struct fifo_is_fixed_width_key<std::array<T, N>>
+        : std::integral_constant<bool, std::is_integral<T>::value && sizeof(T) * N <= 32>
+    {};
+
+    // Hashes the bytes of a fixed-width key, 16 at a time, each folded
+    // in with a 64x64->128-bit multiply that keeps its operands in the
+    // result, so a zero operand doesn't wipe out the other.
+    template <class Key>
+    struct fifo_fixed_width_hash final
+    {
+        auto operator () (Key const& k) const -> std::size_t
+        {
+            auto p = reinterpret_cast<unsigned char const*>(&k);
+            auto n = sizeof(Key);
+
+            std::uint64_t h = seed ^ n;
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+                h = mix(load(p + i, 8) ^ secret, load(p + i + 8, 8) ^ seed ^ h);
+            if (i < n) {
+                auto rest = n - i;
+                auto lo = load(p + i, (rest < 8 ? rest : 8));
+                auto hi = (rest > 8 ? load(p + i + 8, rest - 8) : 0);
+                h = mix(lo ^ secret, hi ^ seed ^ h);
+            }
+            return std::size_t(mix(h ^ seed, n ^ secret));
+        }
+
+    private:
+        static constexpr std::uint64_t seed = 0xa0761d6478bd642full;
+        static constexpr std::uint64_t secret = 0xe7037ed1a0b428dbull;
+
+        static auto load(unsigned char const* p, std::size_t n) -> std::uint64_t
+        {
+            std::uint64_t x = 0;
+            std::memcpy(&x, p, n);
+            return x;
+        }
+
+        static auto mix(std::uint64_t a, std::uint64_t b) -> std::uint64_t
+        {
+#if defined(__SIZEOF_INT128__)
+            __extension__ using u128 = unsigned __int128;
+            auto r = u128(a) * b;
+            return a ^ b ^ std::uint64_t(r) ^ std::uint64_t(r >> 64);
+#else
+            auto a_lo = a & 0xffffffffu, a_hi = a >> 32;
+            auto b_lo = b & 0xffffffffu, b_hi = b >> 32;
+            auto lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+            auto lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+            auto mid = (lo_lo >> 32) + (hi_lo & 0xffffffffu) + lo_hi;
+            auto lo = (mid << 32) | (lo_lo & 0xffffffffu);
+            auto hi = hi_hi + (hi_lo >> 32) + (mid >> 32);
+            return a ^ b ^ lo ^ hi;
+#endif
+        }
+    };
+
+    template <class Key, class Hash, class Equal, class = void>
+    struct fifo_key_reference final
+    {
+        fifo_key_reference(Key const& k): k{k} {}
+
+        auto hash() const -> std::size_t
+        {
+            Hash h{};
+            return h(k);
+        }
+
+        friend auto operator == (fifo_key_reference const& a, fifo_key_reference const& b) -> bool
+        {
+            Equal eq{};
+            return eq(a.k, b.k);
+        }
+
+    private:
+        Key const& k;
+    };
+
+    namespace fifo_detail
+    {
+        template <class Key, class Char, class Hash>
+        struct prefixed_key_reference
+        {
+            prefixed_key_reference(Key const& k)
+                : k{&k}
+                , hash_value{Hash{}(k)}
+                , size{k.size()}
+                , prefix{prefix_of(k.data(), k.size())}
+            {}
+
+            auto hash() const -> std::size_t
+            {
+                return hash_value;
+            }
+
+            friend auto operator == (prefixed_key_reference const& a, prefixed_key_reference const& b) -> bool
+            {
+                if (a.hash_value != b.hash_value || a.size != b.size || a.prefix != b.prefix)
+                    return false;
+                if (a.size <= prefix_chars)
+                    return true;
+
+                auto n = a.size - prefix_chars;
+                return !std::char_traits<Char>::compare(a.k->data() + prefix_chars, b.k->data() + prefix_chars, n);
+            }
+
+        private:
+            static constexpr std::size_t prefix_chars = sizeof(std::uint64_t) / sizeof(Char);
+
+            static auto prefix_of(Char const* s, std::size_t n) -> std::uint64_t
+            {
+                std::uint64_t prefix = 0;
+                if (n) std::memcpy(&prefix, s, (n < prefix_chars ? n : prefix_chars) * sizeof(Char));
+                return prefix;
+            }
+
+            Key const* k;
+            std::size_t hash_value;
+            std::size_t size;
+            std::uint64_t prefix;
+        };
+    }
+
+    template <class Char, class Alloc, class Hash>
+    struct fifo_key_reference<
+        std::basic_string<Char, std::char_traits<Char>, Alloc>
+        , Hash
+        , std::equal_to<std::basic_string<Char, std::char_traits<Char>, Alloc>>
+    > final
+        : fifo_detail::prefixed_key_reference<std::basic_string<Char, std::char_traits<Char>, Alloc>, Char, Hash>
+    {
+        using fifo_detail::prefixed_key_reference<std::basic_string<Char, std::char_traits<Char>, Alloc>, Char, Hash>
+            ::prefixed_key_reference;
+    };
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+    template <class Char, class Hash>
+    struct fifo_key_reference<
+        std::basic_string_view<Char>
+        , Hash
+        , std::equal_to<std::basic_string_view<Char>>
+    > final
+        : fifo_detail::prefixed_key_reference<std::basic_string_view<Char>, Char, Hash>
+    {
+        using fifo_detail::prefixed_key_reference<std::basic_string_view<Char>, Char, Hash>
+            ::prefixed_key_reference;
+    };
+#endif
+
+    template <class Key, class Hash>
+    struct fifo_key_reference<
+        Key
+        , Hash
+        , std::equal_to<Key>
+        , std::enable_if_t<fifo_is_fixed_width_key<Key>::value>
+    > final
+    {
+        static_assert(std::is_trivially_copyable<Key>::value, "fixed-width keys must be trivially copyable");
+
+        fifo_key_reference(Key const& k): k{k} {}
+
+        auto hash() const -> std::size_t
+        {
+            Hash h{};
+            return h(k);
+        }
+
+        friend auto operator == (fifo_key_reference const& a, fifo_key_reference const& b) -> bool
+        {
+            return !std::memcmp(&a.k, &b.k, sizeof(Key));
+        }
+
+    private:
+        // a copy, not a reference; it's no bigger than a couple of pointers
+        Key k;
+    };
+
+    namespace fifo_detail
+    {
+        template <class Key, class Hash>
+        struct fixed_width_key_pointer final
+        {
+            static_assert(std::is_trivially_copyable<Key>::value, "fixed-width keys must be trivially copyable");
+
+            fixed_width_key_pointer(Key const& k): k{&k} {}
+
+            auto hash() const -> std::size_t
+            {
+                Hash h{};
+                return h(*k);
+            }
+
+            friend auto operator == (fixed_width_key_pointer const& a, fixed_width_key_pointer const& b) -> bool
+            {
+                return !std::memcmp(a.k, b.k, sizeof(Key));
+            }
+
+        private:
+            Key const* k;
+        };
+    }
+
+    // fifo_key_reference, except that fixed-width keys are pointed at,
+    // for containers whose values already hold their keys.
+    template <class Key, class Hash, class Equal>
+    using fifo_member_key_reference = std::conditional_t<
+        std::is_same<Equal, std::equal_to<Key>>::value && fifo_is_fixed_width_key<Key>::value
+        , fifo_detail::fixed_width_key_pointer<Key, Hash>
+        , fifo_key_reference<Key, Hash, Equal>
+    >;
+}
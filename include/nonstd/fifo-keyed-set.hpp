@@ -0,0 +1,232 @@
+#pragma once
+// A hash set of objects looked up by a key they contain, which guarantees
+// iteration in insertion-order, for C++14 or above.
+//
+// Where `fifo_map<Id, Record>` would store every id twice, once as the key
+// and once inside the record, `fifo_keyed_set<Record, Key_Of>` stores only
+// the records: the index hashes and compares `Key_Of{}(record)`, and
+// `find`, `count` and `erase` take the key.
+//
+// Like `fifo_set`, it's an `std::list` of values with a lookup index built
+// using `std::unordered_map`. The rest of a record may be changed through
+// iterators, but its key must not be.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-key-reference.hpp"
+#include <unordered_map>
+#include <list>
+#include <type_traits>
+#include <stdexcept>
+#include <cassert>
+
+namespace nonstd
+{
+    template <
+        class T
+        , class Key_Of
+        , class Hash = std::hash<std::decay_t<decltype(Key_Of{}(std::declval<T const&>()))>>
+        , class Key_Equal = std::equal_to<std::decay_t<decltype(Key_Of{}(std::declval<T const&>()))>>
+    >
+    struct fifo_keyed_set final
+    {
+        using key_type = std::decay_t<decltype(Key_Of{}(std::declval<T const&>()))>;
+        using value_type = T;
+        using key_of = Key_Of;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+
+        // The index refers to keys inside the stored values.
+        static_assert(std::is_reference<decltype(Key_Of{}(std::declval<T const&>()))>::value,
+            "Key_Of must return a reference to the key inside the value");
+
+        using list_type = std::list<value_type>;
+        using list_iterator = typename list_type::iterator;
+        using list_const_iterator = typename list_type::const_iterator;
+        using iterator = list_iterator;
+        using const_iterator = list_const_iterator;
+        using reverse_iterator = typename list_type::reverse_iterator;
+        using const_reverse_iterator = typename list_type::const_reverse_iterator;
+
+        using key_reference = fifo_member_key_reference<key_type, hasher, key_equal>;
+
+        struct key_reference_hasher final
+        {
+            auto operator () (key_reference const& kr) const -> std::size_t
+            {
+                return kr.hash();
+            }
+        };
+
+        using map_type = std::unordered_map<key_reference, list_iterator, key_reference_hasher>;
+        using map_iterator = typename map_type::iterator;
+        using size_type = typename map_type::size_type;
+
+        // rule of five; force noexcept move constructible
+        fifo_keyed_set() = default;
+
+        fifo_keyed_set(fifo_keyed_set const& x)
+        {
+            for (auto&& v: x)
+                emplace_back(v);
+        }
+
+        auto operator = (fifo_keyed_set const& x) -> fifo_keyed_set&
+        {
+            if (this != &x) {
+                clear();
+                for (auto&& v: x)
+                    emplace_back(v);
+            }
+            return *this;
+        }
+
+        fifo_keyed_set(fifo_keyed_set&& other) noexcept
+            : map{std::move(other.map)}
+            , list{std::move(other.list)}
+        {}
+
+        auto operator = (fifo_keyed_set&& other) noexcept -> fifo_keyed_set&
+        {
+            map = std::move(other.map);
+            list = std::move(other.list);
+            return *this;
+        }
+
+        // For interface compatibility with std::unordered_set.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto map_it = map.find(key_of{}(value));
+            if (map_it == map.end()) {
+                auto list_it = list.insert(list.end(), std::move(value));
+                map.emplace(key_of{}(*list_it), list_it);
+                return { list_it, true };
+            } else {
+                return { map_it->second, false };
+            }
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto map_it = map.find(key_of{}(value));
+            if (map_it == map.end()) {
+                auto list_it = list.insert(list.begin(), std::move(value));
+                map.emplace(key_of{}(*list_it), list_it);
+                return { list_it, true };
+            } else {
+                return { map_it->second, false };
+            }
+        }
+
+        auto erase(list_iterator list_it) -> void
+        {
+            auto map_it = map.find(key_of{}(*list_it));
+            assert(map_it != map.end());
+
+            map.erase(map_it);
+            list.erase(list_it);
+        }
+
+        auto erase(key_type const& key) -> void
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end()) return;
+
+            auto list_it = map_it->second;
+            map.erase(map_it);
+            list.erase(list_it);
+        }
+
+        auto clear() -> void
+        {
+            map.clear();
+            list.clear();
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            map.reserve(n);
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            return map.count(key);
+        }
+
+        auto size() const -> size_type
+        {
+            return map.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return map.empty();
+        }
+
+        auto find(key_type const& key) const -> const_iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return map_it->second;
+        }
+
+        auto find(key_type const& key) -> iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return map_it->second;
+        }
+
+        auto at(key_type const& key) const -> value_type const&
+        {
+            auto it = find(key);
+            if (it == end()) throw std::out_of_range{"fifo_keyed_set::at"};
+            return *it;
+        }
+
+        auto at(key_type const& key) -> value_type&
+        {
+            auto it = find(key);
+            if (it == end()) throw std::out_of_range{"fifo_keyed_set::at"};
+            return *it;
+        }
+
+        auto begin() -> iterator { return list.begin(); }
+        auto   end() -> iterator { return list.  end(); }
+        auto begin() const -> const_iterator { return list.begin(); }
+        auto   end() const -> const_iterator { return list.  end(); }
+        auto cbegin() const -> const_iterator { return list.cbegin(); }
+        auto   cend() const -> const_iterator { return list.  cend(); }
+        auto rbegin() -> reverse_iterator { return list.rbegin(); }
+        auto   rend() -> reverse_iterator { return list.  rend(); }
+        auto rbegin() const -> const_reverse_iterator { return list.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return list.  rend(); }
+        auto crbegin() const -> const_reverse_iterator { return list.crbegin(); }
+        auto   crend() const -> const_reverse_iterator { return list.  crend(); }
+
+        // Oldest and newest values; the set must not be empty.
+        auto front() -> value_type& { return list.front(); }
+        auto  back() -> value_type& { return list. back(); }
+        auto front() const -> value_type const& { return list.front(); }
+        auto  back() const -> value_type const& { return list. back(); }
+
+    private:
+        map_type map;
+        list_type list;
+    };
+}
@@ -0,0 +1,387 @@
+#pragma once
+// A read-only map over a serialized image that decodes values only when
+// they're asked for, in insertion-order, for C++17 or above.
+//
+// `fifo_lazy_encode` turns a map with string keys into an image:
+//
+//      header   "fifolazy", u64 entry count, u64 offset of the index,
+//               u64 offset of the table, u64 slot count (a power of two)
+//      values   each entry's encoded value, back to back, in insertion-order
+//      index    per entry: u64 value offset, u64 value size, u32 key size, key
+//      table    per slot: u64 hash of the key, u64 offset of its index entry,
+//               or 0 for an empty slot
+//
+// all in host byte order. The table is an open-addressed hash table, at most
+// half full, with linear probing from slot `hash & (slot count - 1)`; the
+// hash is 64-bit FNV-1a over the key's bytes. Of duplicate keys, only the
+// first is in the table.
+//
+// `fifo_lazy_map` reads just the header when it's made, and probes the table
+// in place, so opening is O(1) and allocates nothing; keys are
+// `std::string_view`s into the image, which the caller owns and must keep
+// alive. A value is decoded on its first `find` or `at` and cached, so
+// memory scales with the keys used, not the map. Iteration streams through
+// the index in order, decoding each value as it's reached, and leaves the
+// cache alone. Parts of the image are checked as they're read; a bad one
+// throws `std::invalid_argument`.
+//
+// Lookups fill the cache, so even they must not race with each other.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <optional>
+#include <vector>
+#include <iterator>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+
+namespace nonstd
+{
+    // Encodes and decodes trivially copyable values as their bytes.
+    template <class T>
+    struct fifo_raw_value_codec final
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "fifo_raw_value_codec needs trivially copyable values");
+
+        auto operator () (std::string& buffer, T const& x) const -> void
+        {
+            buffer.append(reinterpret_cast<char const*>(&x), sizeof(x));
+        }
+
+        auto operator () (std::string_view bytes) const -> T
+        {
+            if (bytes.size() != sizeof(T))
+                throw std::invalid_argument{"fifo_raw_value_codec: size mismatch"};
+            T x;
+            std::memcpy(&x, bytes.data(), sizeof(T));
+            return x;
+        }
+    };
+
+    namespace fifo_detail
+    {
+        constexpr char lazy_magic[8] = {'f', 'i', 'f', 'o', 'l', 'a', 'z', 'y'};
+        constexpr std::size_t lazy_header_size = sizeof(lazy_magic) + 4 * sizeof(std::uint64_t);
+        // u64 value offset, u64 value size, u32 key size
+        constexpr std::size_t lazy_entry_size = 20;
+        // u64 hash, u64 entry offset
+        constexpr std::size_t lazy_slot_size = 16;
+
+        template <class U>
+        auto append_raw(std::string& buffer, U x) -> void
+        {
+            buffer.append(reinterpret_cast<char const*>(&x), sizeof(x));
+        }
+
+        template <class U>
+        auto read_raw(std::string_view bytes, std::size_t at) -> U
+        {
+            U x;
+            std::memcpy(&x, bytes.data() + at, sizeof(x));
+            return x;
+        }
+
+        template <class U>
+        auto write_raw(std::string& buffer, std::size_t at, U x) -> void
+        {
+            std::memcpy(&buffer[at], &x, sizeof(x));
+        }
+
+        // 64-bit FNV-1a; part of the image format, so it must never change.
+        inline auto lazy_hash(std::string_view key) -> std::uint64_t
+        {
+            std::uint64_t h = 0xcbf29ce484222325ull;
+            for (auto c: key) {
+                h ^= static_cast<unsigned char>(c);
+                h *= 0x100000001b3ull;
+            }
+            return h;
+        }
+    }
+
+    // Serializes map, whose keys convert to `std::string_view`, encoding
+    // each value with encode(buffer, value).
+    template <class Map, class Encode>
+    auto fifo_lazy_encode(Map const& map, Encode encode) -> std::string
+    {
+        using fifo_detail::append_raw;
+
+        struct placement final
+        {
+            std::string_view key;
+            std::uint64_t offset;
+            std::uint64_t size;
+        };
+
+        std::vector<placement> placements;
+        placements.reserve(map.size());
+
+        std::string image(fifo_detail::lazy_header_size, '\0');
+        for (auto&& kv: map) {
+            auto offset = image.size();
+            encode(image, kv.second);
+            placements.push_back({ std::string_view{kv.first}, offset, image.size() - offset });
+        }
+
+        auto index_offset = std::uint64_t(image.size());
+        std::vector<std::uint64_t> entry_offsets;
+        entry_offsets.reserve(placements.size());
+        for (auto&& p: placements) {
+            if (p.key.size() > UINT32_MAX) throw std::length_error{"fifo_lazy_encode"};
+            entry_offsets.push_back(image.size());
+            append_raw(image, p.offset);
+            append_raw(image, p.size);
+            append_raw(image, std::uint32_t(p.key.size()));
+            image.append(p.key);
+        }
+
+        // at most half full
+        std::uint64_t slot_count = 1;
+        while (slot_count < 2 * placements.size()) slot_count *= 2;
+
+        // which placement each slot holds, 0 for none
+        std::vector<std::size_t> slots(slot_count);
+        auto table_offset = std::uint64_t(image.size());
+        image.append(slot_count * fifo_detail::lazy_slot_size, '\0');
+
+        for (std::size_t n = 0; n < placements.size(); n++) {
+            auto key = placements[n].key;
+            auto hash = fifo_detail::lazy_hash(key);
+            auto i = hash & (slot_count - 1);
+            while (slots[i] && placements[slots[i] - 1].key != key)
+                i = (i + 1) & (slot_count - 1);
+            if (slots[i]) continue;
+
+            slots[i] = n + 1;
+            auto at = table_offset + i * fifo_detail::lazy_slot_size;
+            fifo_detail::write_raw(image, at, hash);
+            fifo_detail::write_raw(image, at + 8, entry_offsets[n]);
+        }
+
+        auto count = std::uint64_t(placements.size());
+        std::memcpy(&image[0], fifo_detail::lazy_magic, sizeof(fifo_detail::lazy_magic));
+        fifo_detail::write_raw(image, 8, count);
+        fifo_detail::write_raw(image, 16, index_offset);
+        fifo_detail::write_raw(image, 24, table_offset);
+        fifo_detail::write_raw(image, 32, slot_count);
+        return image;
+    }
+
+    template <
+        class T
+        , class Decode = fifo_raw_value_codec<T>
+    >
+    struct fifo_lazy_map final
+    {
+        using key_type = std::string_view;
+        using mapped_type = T;
+        using value_type = std::pair<key_type, mapped_type>;
+        using size_type = std::size_t;
+
+    private:
+        // An index entry as read from the image.
+        struct entry final
+        {
+            key_type key;
+            std::uint64_t offset;
+            std::uint64_t size;
+            // where the next entry starts
+            std::size_t next;
+        };
+
+    public:
+        // Decodes each entry as it's reached; an input iterator.
+        struct const_iterator final
+        {
+            using iterator_category = std::input_iterator_tag;
+            using value_type = fifo_lazy_map::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = value_type const*;
+            using reference = value_type const&;
+
+            const_iterator() = default;
+            const_iterator(fifo_lazy_map const* map, size_type position, std::size_t at)
+                : map{map}, position{position}, at{at}
+            {}
+
+            auto operator * () const -> reference
+            {
+                if (!current) {
+                    auto e = map->entry_at(at);
+                    current.emplace(e.key, map->decode_entry(e));
+                }
+                return *current;
+            }
+
+            auto operator -> () const -> pointer { return &**this; }
+
+            auto operator ++ () -> const_iterator&
+            {
+                at = map->entry_at(at).next;
+                ++position;
+                current.reset();
+                return *this;
+            }
+
+            auto operator ++ (int) -> const_iterator { auto x = *this; ++*this; return x; }
+
+            // The entry's key, without decoding its value.
+            auto key() const -> key_type { return map->entry_at(at).key; }
+
+            friend auto operator == (const_iterator const& a, const_iterator const& b) -> bool { return a.position == b.position; }
+            friend auto operator != (const_iterator const& a, const_iterator const& b) -> bool { return a.position != b.position; }
+
+        private:
+            fifo_lazy_map const* map{};
+            size_type position{};
+            // offset of the entry in the image
+            std::size_t at{};
+            mutable std::optional<value_type> current;
+        };
+
+        using iterator = const_iterator;
+
+        // Reads the header of image; throws std::invalid_argument if it
+        // doesn't hold together. The rest is checked as it's read.
+        explicit fifo_lazy_map(std::string_view image, Decode decode = {})
+            : image{image}
+            , decode{std::move(decode)}
+        {
+            using fifo_detail::read_raw;
+
+            auto header_size = fifo_detail::lazy_header_size;
+            if (image.size() < header_size || std::memcmp(image.data(), fifo_detail::lazy_magic, sizeof(fifo_detail::lazy_magic)) != 0)
+                bad_image();
+
+            auto count = read_raw<std::uint64_t>(image, 8);
+            auto index_offset = read_raw<std::uint64_t>(image, 16);
+            auto table_offset = read_raw<std::uint64_t>(image, 24);
+            auto slot_count = read_raw<std::uint64_t>(image, 32);
+
+            if (index_offset < header_size || index_offset > table_offset || table_offset > image.size()) bad_image();
+            // Each index entry takes 20 bytes at least; don't trust count further.
+            if (count > (table_offset - index_offset) / fifo_detail::lazy_entry_size) bad_image();
+            if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0) bad_image();
+            if (slot_count > (image.size() - table_offset) / fifo_detail::lazy_slot_size) bad_image();
+
+            entry_count = size_type(count);
+            index_start = std::size_t(index_offset);
+            table_start = std::size_t(table_offset);
+            slots = std::size_t(slot_count);
+        }
+
+        auto count(key_type key) const -> size_type
+        {
+            return (find_entry(key) ? 1 : 0);
+        }
+
+        auto size() const -> size_type
+        {
+            return entry_count;
+        }
+
+        auto empty() const -> bool
+        {
+            return entry_count == 0;
+        }
+
+        // The value for key, decoded and cached if it isn't already,
+        // or nullptr if there isn't one.
+        auto find(key_type key) -> mapped_type const*
+        {
+            auto at = find_entry(key);
+            if (!at) return nullptr;
+
+            auto it = cache.find(at);
+            if (it == cache.end())
+                it = cache.emplace(at, decode_entry(entry_at(at))).first;
+            return &it->second;
+        }
+
+        auto at(key_type key) -> mapped_type const&
+        {
+            auto x = find(key);
+            if (!x) throw std::out_of_range{"fifo_lazy_map::at"};
+            return *x;
+        }
+
+        // How many values have been decoded and kept.
+        auto cached() const -> size_type
+        {
+            return cache.size();
+        }
+
+        auto clear_cache() -> void
+        {
+            cache.clear();
+        }
+
+        auto begin() const -> const_iterator { return { this, 0, index_start }; }
+        auto   end() const -> const_iterator { return { this, size(), table_start }; }
+        auto cbegin() const -> const_iterator { return begin(); }
+        auto   cend() const -> const_iterator { return end(); }
+
+    private:
+        [[noreturn]] static auto bad_image() -> void
+        {
+            throw std::invalid_argument{"fifo_lazy_map: bad image"};
+        }
+
+        // Reads and checks the index entry at offset at.
+        auto entry_at(std::size_t at) const -> entry
+        {
+            using fifo_detail::read_raw;
+
+            if (at < index_start || at > table_start || table_start - at < fifo_detail::lazy_entry_size) bad_image();
+            auto offset = read_raw<std::uint64_t>(image, at);
+            auto size = read_raw<std::uint64_t>(image, at + 8);
+            auto key_size = read_raw<std::uint32_t>(image, at + 16);
+            at += fifo_detail::lazy_entry_size;
+
+            if (offset < fifo_detail::lazy_header_size || offset > index_start || size > index_start - offset) bad_image();
+            if (key_size > table_start - at) bad_image();
+            return { image.substr(at, key_size), offset, size, at + key_size };
+        }
+
+        // Offset of key's index entry, or 0 if it isn't there.
+        auto find_entry(key_type key) const -> std::size_t
+        {
+            using fifo_detail::read_raw;
+
+            auto hash = fifo_detail::lazy_hash(key);
+            auto i = std::size_t(hash) & (slots - 1);
+            // a table with no empty slot must not loop forever
+            for (std::size_t probes = 0; probes < slots; probes++) {
+                auto slot = table_start + i * fifo_detail::lazy_slot_size;
+                auto at = read_raw<std::uint64_t>(image, slot + 8);
+                if (at == 0) return 0;
+                if (read_raw<std::uint64_t>(image, slot) == hash) {
+                    if (at > table_start) bad_image();
+                    if (entry_at(std::size_t(at)).key == key) return std::size_t(at);
+                }
+                i = (i + 1) & (slots - 1);
+            }
+            return 0;
+        }
+
+        auto decode_entry(entry const& e) const -> mapped_type
+        {
+            return decode(image.substr(std::size_t(e.offset), std::size_t(e.size)));
+        }
+
+        std::string_view image;
+        Decode decode;
+        size_type entry_count{};
+        std::size_t index_start{};
+        std::size_t table_start{};
+        std::size_t slots{};
+        // decoded values by index entry offset
+        std::unordered_map<std::size_t, mapped_type> cache;
+    };
+}
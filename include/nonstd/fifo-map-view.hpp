@@ -0,0 +1,63 @@
+#pragma once
+// A map of `std::string_view`s into a caller-owned buffer, in insertion-order,
+// for C++17 or above.
+//
+// `fifo_map_view` is a `fifo_dense_map` from `std::string_view` to
+// `std::string_view`: neither keys nor values are copied, so the buffer must
+// outlive the view. The only memory it owns is the entry array and the index,
+// and both come from Allocator; pass a `std::pmr::polymorphic_allocator` to
+// take them from a request-scoped arena. Lookups take a `std::string_view`,
+// so `std::string`s and string literals are looked up without a copy.
+//
+// `fifo_split_view` fills one from text such as `a=1&b=2`, reserving once.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-dense-map.hpp"
+#include <string_view>
+#include <algorithm>
+#include <memory>
+
+namespace nonstd
+{
+    template <
+        class Hash = std::hash<std::string_view>
+        , class Key_Equal = std::equal_to<std::string_view>
+        , class Allocator = std::allocator<std::pair<std::string_view, std::string_view>>
+    >
+    using fifo_map_view = fifo_dense_map<std::string_view, std::string_view, Hash, Key_Equal, Allocator>;
+
+    // Splits text into pairs at pair_separator, and each pair into key and
+    // value at the first key_value_separator; a pair without one has an empty
+    // value. Empty pairs are skipped, and the first of duplicate keys wins.
+    // The views point into text.
+    template <class Map>
+    auto fifo_split_view(
+        Map& map
+        , std::string_view text
+        , char pair_separator = '&'
+        , char key_value_separator = '='
+    ) -> Map&
+    {
+        if (text.empty()) return map;
+        map.reserve(map.size() + static_cast<std::size_t>(std::count(text.begin(), text.end(), pair_separator)) + 1);
+
+        while (true) {
+            auto end = text.find(pair_separator);
+            auto pair = text.substr(0, end);
+
+            if (!pair.empty()) {
+                auto middle = pair.find(key_value_separator);
+                if (middle == std::string_view::npos)
+                    map.emplace_back(pair, std::string_view{});
+                else
+                    map.emplace_back(pair.substr(0, middle), pair.substr(middle + 1));
+            }
+
+            if (end == std::string_view::npos) break;
+            text.remove_prefix(end + 1);
+        }
+        return map;
+    }
+}
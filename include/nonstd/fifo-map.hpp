@@ -5,8 +5,9 @@
 // (Yes, it's similar to nlohmann::fifo_map, but this one uses
 // `std::unordered_map` instead of `std::map`.)
 //
-// It's basically an `std::forward_list` of key/value pairs,
+// It's basically an `std::list` of key/value pairs,
 // with a lookup index built using `std::unordered_map`.
+// Iterators are bidirectional, so newest-first is just `rbegin()`.
 //
 // It's a drop-in replacement for `std::unordered_map`
 // if the interface you used was implemented.
@@ -17,8 +18,9 @@
 // Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2020.
 // Licensed under the MIT License.
 
+#include "fifo-key-reference.hpp"
 #include <unordered_map>
-#include <forward_list>
+#include <list>
 #include <cassert>
 
 namespace nonstd
@@ -37,31 +39,15 @@ namespace nonstd
         using key_equal = Key_Equal;
 
         using value_type = std::pair<key_type const, mapped_type>;
-        using list_type = std::forward_list<value_type>;
+        using list_type = std::list<value_type>;
         using list_iterator = typename list_type::iterator;
         using list_const_iterator = typename list_type::const_iterator;
         using iterator = list_iterator;
         using const_iterator = list_const_iterator;
+        using reverse_iterator = typename list_type::reverse_iterator;
+        using const_reverse_iterator = typename list_type::const_reverse_iterator;
 
-        struct key_reference final
-        {
-            key_reference(key_type const& k): k{k} {}
-
-            auto hash() const -> std::size_t
-            {
-                hasher h{};
-                return h(k);
-            }
-
-            friend auto operator == (key_reference const& a, key_reference const& b) -> bool
-            {
-                key_equal eq{};
-                return eq(a.k, b.k);
-            }
-
-        private:
-            key_type const& k;
-        };
+        using key_reference = fifo_key_reference<key_type, hasher, key_equal>;
 
         struct key_reference_hasher final
         {
@@ -95,17 +81,12 @@ namespace nonstd
         fifo_map(fifo_map&& other) noexcept
             : map{std::move(other.map)}
             , list{std::move(other.list)}
-            , list_back{(list.empty() ? list.before_begin() : other.list_back)}
-        {
-            if (!list.empty()) map.at(list.front().first) = list.before_begin();
-        }
+        {}
 
         auto operator = (fifo_map&& other) noexcept -> fifo_map&
         {
             map = std::move(other.map);
             list = std::move(other.list);
-            list_back = (list.empty() ? list.before_begin() : other.list_back);
-            if (!list.empty()) map.at(list.front().first) = list.before_begin();
             return *this;
         }
 
@@ -123,16 +104,11 @@ namespace nonstd
 
             auto map_it = map.find(value.first);
             if (map_it == map.end()) {
-                auto list_before_item = list_back;
-                list_back = list.insert_after(list_back, std::move(value));
-
-                map.emplace(list_back->first, list_before_item);
-
-                return { list_back, true };
+                auto list_it = list.insert(list.end(), std::move(value));
+                map.emplace(list_it->first, list_it);
+                return { list_it, true };
             } else {
-                auto list_it = map_it->second;
-                ++list_it;
-                return { list_it, false };
+                return { map_it->second, false };
             }
         }
 
@@ -143,17 +119,11 @@ namespace nonstd
 
             auto map_it = map.find(value.first);
             if (map_it == map.end()) {
-                auto& list_it = (empty() ? list_back : map.at(list.front().first));
-                auto list_before_item = list_it;
-                list_it = list.insert_after(list_before_item, std::move(value));
-
-                map.emplace(list_it->first, list_before_item);
-
+                auto list_it = list.insert(list.begin(), std::move(value));
+                map.emplace(list_it->first, list_it);
                 return { list_it, true };
             } else {
-                auto list_it = map_it->second;
-                ++list_it;
-                return { list_it, false };
+                return { map_it->second, false };
             }
         }
 
@@ -162,16 +132,8 @@ namespace nonstd
             auto map_it = map.find(list_it->first);
             assert(map_it != map.end());
 
-            auto list_before_item = map_it->second;
             map.erase(map_it);
-
-            list_it = list.erase_after(list_before_item);
-
-            if (list_it == list.end()) {
-                list_back = list_before_item;
-            } else {
-                map.at(list_it->first) = list_before_item;
-            }
+            list.erase(list_it);
         }
 
         auto erase(key_type const& key) -> void
@@ -179,23 +141,20 @@ namespace nonstd
             auto map_it = map.find(key);
             if (map_it == map.end()) return;
 
-            auto list_before_item = map_it->second;
+            auto list_it = map_it->second;
             map.erase(map_it);
-
-            auto list_it = list.erase_after(list_before_item);
-
-            if (list_it == list.end()) {
-                list_back = list_before_item;
-            } else {
-                map.at(list_it->first) = list_before_item;
-            }
+            list.erase(list_it);
         }
 
         auto clear() -> void
         {
             map.clear();
             list.clear();
-            list_back = list.before_begin();
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            map.reserve(n);
         }
 
         auto count(key_type const& key) const -> size_type
@@ -218,9 +177,7 @@ namespace nonstd
             auto map_it = map.find(key);
             if (map_it == map.end())
                 return end();
-
-            auto list_before_item = map_it->second;
-            return ++list_before_item;
+            return map_it->second;
         }
 
         auto find(key_type const& key) -> iterator
@@ -228,23 +185,17 @@ namespace nonstd
             auto map_it = map.find(key);
             if (map_it == map.end())
                 return end();
-
-            auto list_before_item = map_it->second;
-            return ++list_before_item;
+            return map_it->second;
         }
 
         auto at(key_type const& key) const -> mapped_type const&
         {
-            auto list_it = map.at(key);
-            ++list_it;
-            return list_it->second;
+            return map.at(key)->second;
         }
 
         auto at(key_type const& key) -> mapped_type&
         {
-            auto list_it = map.at(key);
-            ++list_it;
-            return list_it->second;
+            return map.at(key)->second;
         }
 
         auto operator [] (key_type const& key) -> mapped_type&
@@ -262,11 +213,22 @@ namespace nonstd
         auto   end() const -> const_iterator { return list.  end(); }
         auto cbegin() const -> const_iterator { return list.cbegin(); }
         auto   cend() const -> const_iterator { return list.  cend(); }
+        auto rbegin() -> reverse_iterator { return list.rbegin(); }
+        auto   rend() -> reverse_iterator { return list.  rend(); }
+        auto rbegin() const -> const_reverse_iterator { return list.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return list.  rend(); }
+        auto crbegin() const -> const_reverse_iterator { return list.crbegin(); }
+        auto   crend() const -> const_reverse_iterator { return list.  crend(); }
+
+        // Oldest and newest entries; the map must not be empty.
+        auto front() -> value_type& { return list.front(); }
+        auto  back() -> value_type& { return list. back(); }
+        auto front() const -> value_type const& { return list.front(); }
+        auto  back() const -> value_type const& { return list. back(); }
 
     private:
         map_type map;
         list_type list;
-        list_iterator list_back{list.before_begin()};
     };
 }
 
@@ -0,0 +1,704 @@
+#pragma once
+// A container of values in insertion-order with any number of hash indexes
+// on keys inside them, for C++14 or above.
+//
+// Like `fifo_set`, it's a doubly linked list of values, but instead of one
+// lookup index it has one per index spec, each built using
+// `std::unordered_map` from a key that the spec's `Key_Of` reads out of a
+// value. All of them refer into the same list nodes, so every value is
+// stored once.
+//
+//      struct order { std::uint64_t id; std::string account; ... };
+//      fifo_multi_index<order
+//          , fifo_unique_index<fifo_member_key<order, std::uint64_t, &order::id>>
+//          , fifo_non_unique_index<fifo_member_key<order, std::string, &order::account>>
+//      > orders;
+//      orders.get<1>().equal_range("alice");
+//
+// Values are const through iterators, as any part of them may be a key;
+// change them with `modify`.
+//
+// A non-unique index maps each key to a chain of the values sharing it,
+// linked through the nodes as in `fifo_multimap`: two pointers per value
+// and index, and no container per key. Erasing any one value is O(1) in
+// every index, and `get<I>().erase(key)` is O(k) for k values with that key.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-key-reference.hpp"
+#include <unordered_map>
+#include <array>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include <cassert>
+
+namespace nonstd
+{
+    namespace fifo_detail
+    {
+        template <class T, class Key_Of>
+        using key_of_t = std::decay_t<decltype(Key_Of{}(std::declval<T const&>()))>;
+
+        template <class Key_Of, class Hash, class Key_Equal, bool Unique>
+        struct index_spec
+        {
+            using key_of = Key_Of;
+            using hasher = Hash;
+            using key_equal = Key_Equal;
+            using is_unique = std::integral_constant<bool, Unique>;
+        };
+    }
+
+    // At most one value per key.
+    template <
+        class Key_Of
+        , class Hash = void
+        , class Key_Equal = void
+    >
+    struct fifo_unique_index final: fifo_detail::index_spec<Key_Of, Hash, Key_Equal, true> {};
+
+    // Any number of values per key.
+    template <
+        class Key_Of
+        , class Hash = void
+        , class Key_Equal = void
+    >
+    struct fifo_non_unique_index final: fifo_detail::index_spec<Key_Of, Hash, Key_Equal, false> {};
+
+    namespace fifo_detail
+    {
+        // What both kinds of index share; void Hash or Key_Equal mean the std ones.
+        template <class T, class Spec>
+        struct multi_index_keys
+        {
+            using key_of = typename Spec::key_of;
+            using key_type = key_of_t<T, key_of>;
+            using hasher = std::conditional_t<std::is_void<typename Spec::hasher>::value, std::hash<key_type>, typename Spec::hasher>;
+            using key_equal = std::conditional_t<std::is_void<typename Spec::key_equal>::value, std::equal_to<key_type>, typename Spec::key_equal>;
+            using is_unique = typename Spec::is_unique;
+
+            // The index refers to keys inside the stored values.
+            static_assert(std::is_reference<decltype(key_of{}(std::declval<T const&>()))>::value,
+                "Key_Of must return a reference to the key inside the value");
+
+            using key_reference = fifo_member_key_reference<key_type, hasher, key_equal>;
+
+            struct key_reference_hasher final
+            {
+                auto operator () (key_reference const& kr) const -> std::size_t
+                {
+                    return kr.hash();
+                }
+            };
+        };
+
+        // A node's neighbors with the same key in one non-unique index.
+        template <class Node>
+        struct same_key_links final
+        {
+            Node* prev;
+            Node* next;
+        };
+
+        // Which of a node's same_key_links the i-th index uses: one per
+        // non-unique index, in order.
+        template <class... Specs>
+        constexpr auto chain_slot(std::size_t i) -> std::size_t
+        {
+            constexpr bool unique[] = { Specs::is_unique::value..., true };
+            std::size_t n = 0;
+            for (std::size_t k = 0; k < i; k++)
+                if (!unique[k]) n++;
+            return n;
+        }
+
+        // One index of a fifo_multi_index, over its nodes.
+        template <class T, class Node, class Spec, std::size_t Slot, bool Unique = Spec::is_unique::value>
+        struct multi_index_table;
+
+        template <class T, class Node, class Spec, std::size_t Slot>
+        struct multi_index_table<T, Node, Spec, Slot, true> final: multi_index_keys<T, Spec>
+        {
+            using base = multi_index_keys<T, Spec>;
+            using typename base::key_of;
+            using typename base::key_type;
+            using typename base::key_reference;
+            using typename base::key_reference_hasher;
+
+            using map_type = std::unordered_map<key_reference, Node*, key_reference_hasher>;
+            // walks the values with one key
+            using position = typename map_type::const_iterator;
+
+            static auto target(position at) -> Node* { return at->second; }
+            static auto advance(position& at) -> void { ++at; }
+
+            auto find(key_type const& key) const -> Node*
+            {
+                auto map_it = map.find(key);
+                return (map_it == map.end() ? nullptr : map_it->second);
+            }
+
+            auto count(key_type const& key) const -> std::size_t
+            {
+                return map.count(key);
+            }
+
+            auto equal_range(key_type const& key) const -> std::pair<position, position>
+            {
+                return map.equal_range(key);
+            }
+
+            // The value that takes this key already.
+            auto conflict(T const& x) const -> Node*
+            {
+                return find(key_of{}(x));
+            }
+
+            auto insert(Node* item, bool) -> void
+            {
+                map.emplace(key_of{}(item->value), item);
+            }
+
+            auto erase(Node* item) -> void
+            {
+                auto n = map.erase(key_of{}(item->value));
+                assert(n == 1 && "value missing from index");
+                (void) n;
+            }
+
+            auto clear() -> void { map.clear(); }
+            auto reserve(std::size_t n) -> void { map.reserve(n); }
+
+        private:
+            map_type map;
+        };
+
+        // Values sharing a key are chained through their nodes' Slot-th
+        // same_key_links, so any one of them is erased in O(1).
+        template <class T, class Node, class Spec, std::size_t Slot>
+        struct multi_index_table<T, Node, Spec, Slot, false> final: multi_index_keys<T, Spec>
+        {
+            using base = multi_index_keys<T, Spec>;
+            using typename base::key_of;
+            using typename base::key_type;
+            using typename base::key_reference;
+            using typename base::key_reference_hasher;
+
+            struct chain final
+            {
+                Node* first;
+                Node* last;
+                // the value whose key the index refers to
+                Node* owner;
+                std::size_t count;
+            };
+
+            using map_type = std::unordered_map<key_reference, chain, key_reference_hasher>;
+            using position = Node*;
+
+            static auto target(position at) -> Node* { return at; }
+            static auto advance(position& at) -> void { at = at->same[Slot].next; }
+
+            auto find(key_type const& key) const -> Node*
+            {
+                auto map_it = map.find(key);
+                return (map_it == map.end() ? nullptr : map_it->second.first);
+            }
+
+            auto count(key_type const& key) const -> std::size_t
+            {
+                auto map_it = map.find(key);
+                return (map_it == map.end() ? 0 : map_it->second.count);
+            }
+
+            auto equal_range(key_type const& key) const -> std::pair<position, position>
+            {
+                auto map_it = map.find(key);
+                if (map_it == map.end()) return {};
+                return { map_it->second.first, nullptr };
+            }
+
+            auto conflict(T const&) const -> Node*
+            {
+                return nullptr;
+            }
+
+            // At the front of its chain, or at the back.
+            auto insert(Node* item, bool front) -> void
+            {
+                auto&& links = item->same[Slot];
+                links = {};
+
+                auto map_it = map.find(key_of{}(item->value));
+                if (map_it == map.end()) {
+                    map.emplace(key_of{}(item->value), chain{item, item, item, 1});
+                    return;
+                }
+
+                auto&& c = map_it->second;
+                if (front) {
+                    links.next = c.first;
+                    c.first->same[Slot].prev = item;
+                    c.first = item;
+                } else {
+                    links.prev = c.last;
+                    c.last->same[Slot].next = item;
+                    c.last = item;
+                }
+                ++c.count;
+            }
+
+            auto erase(Node* item) -> void
+            {
+                auto map_it = map.find(key_of{}(item->value));
+                assert(map_it != map.end() && "value missing from index");
+
+                auto&& c = map_it->second;
+                if (c.count == 1) {
+                    map.erase(map_it);
+                    return;
+                }
+
+                auto&& links = item->same[Slot];
+                (links.prev ? links.prev->same[Slot].next : c.first) = links.next;
+                (links.next ? links.next->same[Slot].prev : c.last) = links.prev;
+                --c.count;
+
+                if (c.owner == item) {
+                    // The index refers to the key inside item; hand that to another value.
+                    auto rest = c;
+                    rest.owner = rest.first;
+                    map.erase(map_it);
+                    map.emplace(key_of{}(rest.owner->value), rest);
+                }
+            }
+
+            auto clear() -> void { map.clear(); }
+            auto reserve(std::size_t n) -> void { map.reserve(n); }
+
+        private:
+            map_type map;
+        };
+    }
+
+    template <class T, class... Indexes>
+    struct fifo_multi_index final
+    {
+        using value_type = T;
+        using size_type = std::size_t;
+
+    private:
+        struct link
+        {
+            link* prev;
+            link* next;
+        };
+
+        struct node final: link
+        {
+            template <class... Args>
+            node(Args&&... args): value{std::forward<Args>(args)...} {}
+
+            value_type value;
+            // neighbors with the same key, one pair per non-unique index
+            std::array<fifo_detail::same_key_links<node>, fifo_detail::chain_slot<Indexes...>(sizeof...(Indexes))> same;
+        };
+
+        template <class Sequence>
+        struct tables_of;
+
+        template <std::size_t... Is>
+        struct tables_of<std::index_sequence<Is...>>
+        {
+            using type = std::tuple<fifo_detail::multi_index_table<T, node, Indexes, fifo_detail::chain_slot<Indexes...>(Is)>...>;
+        };
+
+    public:
+        using tables_type = typename tables_of<std::index_sequence_for<Indexes...>>::type;
+
+        template <std::size_t I>
+        using table_type = std::tuple_element_t<I, tables_type>;
+
+        // Walks every value in insertion-order; values are const.
+        struct const_iterator final
+        {
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = fifo_multi_index::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = value_type const*;
+            using reference = value_type const&;
+
+            const_iterator() = default;
+            explicit const_iterator(link const* at): at{at} {}
+
+            auto operator *  () const -> reference { return static_cast<node const*>(at)->value; }
+            auto operator -> () const -> pointer { return &static_cast<node const*>(at)->value; }
+
+            auto operator ++ () -> const_iterator& { at = at->next; return *this; }
+            auto operator -- () -> const_iterator& { at = at->prev; return *this; }
+            auto operator ++ (int) -> const_iterator { auto x = *this; ++*this; return x; }
+            auto operator -- (int) -> const_iterator { auto x = *this; --*this; return x; }
+
+            friend auto operator == (const_iterator const& a, const_iterator const& b) -> bool { return a.at == b.at; }
+            friend auto operator != (const_iterator const& a, const_iterator const& b) -> bool { return a.at != b.at; }
+
+        private:
+            friend fifo_multi_index;
+            link const* at{};
+        };
+
+        using iterator = const_iterator;
+        using reverse_iterator = std::reverse_iterator<const_iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        // Walks the values with one key. In a non-unique index that's in the
+        // order they got the key, emplace_front's going first.
+        template <std::size_t I>
+        struct key_iterator final
+        {
+            using base_type = typename table_type<I>::position;
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = fifo_multi_index::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = value_type const*;
+            using reference = value_type const&;
+
+            key_iterator() = default;
+            explicit key_iterator(base_type at): at{at} {}
+
+            // The same value in insertion-order.
+            auto list_position() const -> const_iterator { return const_iterator{table_type<I>::target(at)}; }
+
+            auto operator *  () const -> reference { return table_type<I>::target(at)->value; }
+            auto operator -> () const -> pointer { return &table_type<I>::target(at)->value; }
+
+            auto operator ++ () -> key_iterator& { table_type<I>::advance(at); return *this; }
+            auto operator ++ (int) -> key_iterator { auto x = *this; ++*this; return x; }
+
+            friend auto operator == (key_iterator const& a, key_iterator const& b) -> bool { return a.at == b.at; }
+            friend auto operator != (key_iterator const& a, key_iterator const& b) -> bool { return a.at != b.at; }
+
+        private:
+            base_type at{};
+        };
+
+        template <std::size_t I>
+        struct key_range final
+        {
+            key_range(key_iterator<I> first, key_iterator<I> last): first{first}, last{last} {}
+
+            auto begin() const -> key_iterator<I> { return first; }
+            auto   end() const -> key_iterator<I> { return last; }
+            auto empty() const -> bool { return first == last; }
+
+        private:
+            key_iterator<I> first;
+            key_iterator<I> last;
+        };
+
+        // Lookups by the I-th index. Owner is fifo_multi_index, const or not.
+        template <std::size_t I, class Owner>
+        struct index_view final
+        {
+            using key_type = typename table_type<I>::key_type;
+
+            explicit index_view(Owner* owner): owner{owner} {}
+
+            // A value with this key; for a non-unique index, the first of them.
+            auto find(key_type const& key) const -> const_iterator
+            {
+                auto at = table().find(key);
+                return (at ? const_iterator{at} : owner->end());
+            }
+
+            auto count(key_type const& key) const -> size_type
+            {
+                return table().count(key);
+            }
+
+            auto equal_range(key_type const& key) const -> key_range<I>
+            {
+                auto range = table().equal_range(key);
+                return { key_iterator<I>{range.first}, key_iterator<I>{range.second} };
+            }
+
+            // Erases every value with this key, returns how many.
+            template <class O = Owner, class = std::enable_if_t<!std::is_const<O>::value>>
+            auto erase(key_type const& key) const -> size_type
+            {
+                return owner->template erase_key<I>(key);
+            }
+
+        private:
+            auto table() const -> table_type<I> const&
+            {
+                return std::get<I>(owner->tables);
+            }
+
+            Owner* owner;
+        };
+
+        // rule of five; force noexcept move constructible
+        fifo_multi_index() = default;
+
+        fifo_multi_index(fifo_multi_index const& x)
+        {
+            for (auto&& v: x)
+                emplace_back(v);
+        }
+
+        auto operator = (fifo_multi_index const& x) -> fifo_multi_index&
+        {
+            if (this != &x) {
+                clear();
+                for (auto&& v: x)
+                    emplace_back(v);
+            }
+            return *this;
+        }
+
+        fifo_multi_index(fifo_multi_index&& other) noexcept
+            : tables{std::move(other.tables)}
+        {
+            take_list(other);
+        }
+
+        auto operator = (fifo_multi_index&& other) noexcept -> fifo_multi_index&
+        {
+            if (this != &other) {
+                clear();
+                tables = std::move(other.tables);
+                take_list(other);
+            }
+            return *this;
+        }
+
+        ~fifo_multi_index()
+        {
+            clear();
+        }
+
+        template <std::size_t I>
+        auto get() -> index_view<I, fifo_multi_index>
+        {
+            return index_view<I, fifo_multi_index>{this};
+        }
+
+        template <std::size_t I>
+        auto get() const -> index_view<I, fifo_multi_index const>
+        {
+            return index_view<I, fifo_multi_index const>{this};
+        }
+
+        // For interface compatibility with std::unordered_set.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        // Fails if a unique index has the key already,
+        // and returns the value that has it.
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(false, std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(true, std::forward<Args>(args)...);
+        }
+
+        auto erase(const_iterator it) -> void
+        {
+            auto item = node_of(it);
+            for_each_table([&] (auto& table) { table.erase(item); });
+            unlink(item);
+            delete item;
+        }
+
+        // Applies f to the value in place and reindexes it. If that makes it
+        // collide with another value in a unique index, it's erased instead
+        // and false is returned. If f throws, the value is erased too.
+        template <class F>
+        auto modify(const_iterator it, F&& f) -> bool
+        {
+            auto item = node_of(it);
+            for_each_table([&] (auto& table) { table.erase(item); });
+            try {
+                std::forward<F>(f)(item->value);
+            } catch (...) {
+                // it's in no index now, and may be half-changed
+                unlink(item);
+                delete item;
+                throw;
+            }
+
+            if (conflict(item->value)) {
+                unlink(item);
+                delete item;
+                return false;
+            }
+            index(item, false);
+            return true;
+        }
+
+        auto clear() -> void
+        {
+            for_each_table([] (auto& table) { table.clear(); });
+            for (auto at = header.next; at != &header; ) {
+                auto next = at->next;
+                delete static_cast<node*>(at);
+                at = next;
+            }
+            header.prev = header.next = &header;
+            count_all = 0;
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            for_each_table([n] (auto& table) { table.reserve(n); });
+        }
+
+        auto size() const -> size_type
+        {
+            return count_all;
+        }
+
+        auto empty() const -> bool
+        {
+            return (count_all == 0);
+        }
+
+        auto begin() const -> const_iterator { return const_iterator{header.next}; }
+        auto   end() const -> const_iterator { return const_iterator{&header}; }
+        auto cbegin() const -> const_iterator { return begin(); }
+        auto   cend() const -> const_iterator { return end(); }
+        auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+        auto   rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+        auto crbegin() const -> const_reverse_iterator { return rbegin(); }
+        auto   crend() const -> const_reverse_iterator { return rend(); }
+
+        // Oldest and newest values; the container must not be empty.
+        auto front() const -> value_type const& { return *begin(); }
+        auto  back() const -> value_type const& { return *--end(); }
+
+    private:
+        static auto node_of(const_iterator it) -> node*
+        {
+            return static_cast<node*>(const_cast<link*>(it.at));
+        }
+
+        template <std::size_t I>
+        auto erase_key(typename table_type<I>::key_type const& key) -> size_type
+        {
+            // Gather first, as erasing changes the range.
+            auto range = std::get<I>(tables).equal_range(key);
+            std::vector<node*> doomed;
+            for (auto at = range.first; at != range.second; table_type<I>::advance(at))
+                doomed.push_back(table_type<I>::target(at));
+
+            for (auto item: doomed)
+                erase(const_iterator{item});
+            return doomed.size();
+        }
+
+        template <class F>
+        auto for_each_table(F&& f) -> void
+        {
+            for_each_table(f, std::index_sequence_for<Indexes...>{});
+        }
+
+        template <class F, std::size_t... Is>
+        auto for_each_table(F& f, std::index_sequence<Is...>) -> void
+        {
+            using expand = int[];
+            (void) expand{ 0, (f(std::get<Is>(tables)), 0)... };
+        }
+
+        // The first value that takes one of x's unique keys, if any.
+        auto conflict(value_type const& x) const -> node*
+        {
+            return conflict(x, std::index_sequence_for<Indexes...>{});
+        }
+
+        template <std::size_t... Is>
+        auto conflict(value_type const& x, std::index_sequence<Is...>) const -> node*
+        {
+            node* found = nullptr;
+            using expand = int[];
+            (void) expand{ 0, (found = (found ? found : std::get<Is>(tables).conflict(x)), 0)... };
+            return found;
+        }
+
+        // Adds a linked item to every index; if one throws, takes it out
+        // of the others and erases it.
+        auto index(node* item, bool front) -> void
+        {
+            std::size_t done = 0;
+            try {
+                for_each_table([&] (auto& table) { table.insert(item, front); ++done; });
+            } catch (...) {
+                std::size_t n = 0;
+                for_each_table([&] (auto& table) { if (n++ < done) table.erase(item); });
+                unlink(item);
+                delete item;
+                throw;
+            }
+        }
+
+        template <class... Args>
+        auto insert_at(bool front, Args&&... args) -> std::pair<iterator, bool>
+        {
+            auto item = new node{std::forward<Args>(args)...};
+            if (auto found = conflict(item->value)) {
+                delete item;
+                return { const_iterator{found}, false };
+            }
+
+            link_before(front ? header.next : &header, item);
+            index(item, front);
+            return { const_iterator{item}, true };
+        }
+
+        auto link_before(link* at, node* item) -> void
+        {
+            item->prev = at->prev;
+            item->next = at;
+            at->prev->next = item;
+            at->prev = item;
+            ++count_all;
+        }
+
+        auto unlink(link* item) -> void
+        {
+            item->prev->next = item->next;
+            item->next->prev = item->prev;
+            --count_all;
+        }
+
+        auto take_list(fifo_multi_index& other) -> void
+        {
+            if (other.header.next == &other.header) return;
+
+            header = other.header;
+            header.next->prev = header.prev->next = &header;
+            count_all = other.count_all;
+
+            other.header.prev = other.header.next = &other.header;
+            other.count_all = 0;
+        }
+
+        tables_type tables;
+        // sentinel of the circular list in insertion-order
+        link header{&header, &header};
+        size_type count_all{};
+    };
+}
@@ -0,0 +1,422 @@
+#pragma once
+// A hash multiset that guarantees iteration in insertion-order
+// for C++14 or above.
+//
+// Every insertion is kept, duplicates included, in one global
+// insertion-order. On top of that, equal values are chained together,
+// also in insertion-order, so `equal_range(x)` walks only those k values,
+// and `count(x)` is O(1).
+//
+// It's basically a doubly linked list of values with a second set of links
+// per distinct value, and a lookup index built using `std::unordered_map`
+// from each distinct value to its chain.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include <unordered_map>
+#include <iterator>
+#include <type_traits>
+#include <cassert>
+
+namespace nonstd
+{
+    template <
+        class T
+        , class Hash = std::hash<T>
+        , class Equal = std::equal_to<T>
+    >
+    struct fifo_multiset final
+    {
+        using value_type = T;
+        using hasher = Hash;
+        using equal = Equal;
+
+    private:
+        struct link
+        {
+            link* prev;
+            link* next;
+        };
+
+        struct node final: link
+        {
+            template <class... Args>
+            node(Args&&... args): value{std::forward<Args>(args)...} {}
+
+            value_type value;
+            // neighbors with an equal value
+            node* prev_same{};
+            node* next_same{};
+        };
+
+    public:
+        struct value_reference final
+        {
+            value_reference(value_type const& x): x{&x} {}
+
+            auto hash() const -> std::size_t
+            {
+                hasher h{};
+                return h(*x);
+            }
+
+            // Point at another value that is equal to this one.
+            // Hash and equality don't change, so the index needn't know.
+            auto rebind(value_type const& other) const -> void
+            {
+                x = &other;
+            }
+
+            friend auto operator == (value_reference const& a, value_reference const& b) -> bool
+            {
+                equal eq{};
+                return eq(*a.x, *b.x);
+            }
+
+        private:
+            mutable value_type const* x;
+        };
+
+        struct value_reference_hasher final
+        {
+            auto operator () (value_reference const& xr) const -> std::size_t
+            {
+                return xr.hash();
+            }
+        };
+
+        struct chain final
+        {
+            node* first;
+            node* last;
+            std::size_t count;
+        };
+
+        using map_type = std::unordered_map<value_reference, chain, value_reference_hasher>;
+        using map_iterator = typename map_type::iterator;
+        using size_type = typename map_type::size_type;
+
+        // Walks every value in insertion-order.
+        template <bool Const>
+        struct basic_iterator final
+        {
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = fifo_multiset::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, value_type const*, value_type*>;
+            using reference = std::conditional_t<Const, value_type const&, value_type&>;
+
+            basic_iterator() = default;
+            explicit basic_iterator(link const* at): at{const_cast<link*>(at)} {}
+
+            // iterator -> const_iterator
+            template <bool Other, class = std::enable_if_t<Const && !Other>>
+            basic_iterator(basic_iterator<Other> const& x): at{x.at} {}
+
+            auto operator *  () const -> reference { return static_cast<node*>(at)->value; }
+            auto operator -> () const -> pointer { return &static_cast<node*>(at)->value; }
+
+            auto operator ++ () -> basic_iterator& { at = at->next; return *this; }
+            auto operator -- () -> basic_iterator& { at = at->prev; return *this; }
+            auto operator ++ (int) -> basic_iterator { auto x = *this; ++*this; return x; }
+            auto operator -- (int) -> basic_iterator { auto x = *this; --*this; return x; }
+
+            friend auto operator == (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at == b.at; }
+            friend auto operator != (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at != b.at; }
+
+        private:
+            friend fifo_multiset;
+            link* at{};
+        };
+
+        // Walks the equal values in insertion-order.
+        template <bool Const>
+        struct basic_equal_iterator final
+        {
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = fifo_multiset::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, value_type const*, value_type*>;
+            using reference = std::conditional_t<Const, value_type const&, value_type&>;
+
+            basic_equal_iterator() = default;
+            explicit basic_equal_iterator(node const* at): at{const_cast<node*>(at)} {}
+
+            // iterator -> const_iterator
+            template <bool Other, class = std::enable_if_t<Const && !Other>>
+            basic_equal_iterator(basic_equal_iterator<Other> const& x): at{x.at} {}
+
+            // To the same value, for erase() and for walking on in insertion-order.
+            template <bool To, class = std::enable_if_t<To || !Const>>
+            operator basic_iterator<To> () const { return basic_iterator<To>{at}; }
+
+            auto operator *  () const -> reference { return at->value; }
+            auto operator -> () const -> pointer { return &at->value; }
+
+            auto operator ++ () -> basic_equal_iterator& { at = at->next_same; return *this; }
+            auto operator ++ (int) -> basic_equal_iterator { auto x = *this; ++*this; return x; }
+
+            friend auto operator == (basic_equal_iterator const& a, basic_equal_iterator const& b) -> bool { return a.at == b.at; }
+            friend auto operator != (basic_equal_iterator const& a, basic_equal_iterator const& b) -> bool { return a.at != b.at; }
+
+        private:
+            friend fifo_multiset;
+            node* at{};
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using equal_iterator = basic_equal_iterator<false>;
+        using const_equal_iterator = basic_equal_iterator<true>;
+
+        // rule of five; force noexcept move constructible
+        fifo_multiset() = default;
+
+        fifo_multiset(fifo_multiset const& x)
+        {
+            for (auto&& kv: x)
+                emplace_back(kv);
+        }
+
+        auto operator = (fifo_multiset const& x) -> fifo_multiset&
+        {
+            if (this != &x) {
+                clear();
+                for (auto&& kv: x)
+                    emplace_back(kv);
+            }
+            return *this;
+        }
+
+        fifo_multiset(fifo_multiset&& other) noexcept
+            : map{std::move(other.map)}
+        {
+            take_list(other);
+        }
+
+        auto operator = (fifo_multiset&& other) noexcept -> fifo_multiset&
+        {
+            if (this != &other) {
+                clear();
+                map = std::move(other.map);
+                take_list(other);
+            }
+            return *this;
+        }
+
+        ~fifo_multiset()
+        {
+            clear();
+        }
+
+        // For interface compatibility with std::unordered_multiset.
+        template <class... Args>
+        auto emplace(Args&&... args) -> iterator
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> iterator
+        {
+            auto item = new node{std::forward<Args>(args)...};
+            link_before(&header, item);
+
+            auto map_it = map.find(item->value);
+            if (map_it == map.end()) {
+                map.emplace(item->value, chain{item, item, 1});
+            } else {
+                auto&& c = map_it->second;
+                item->prev_same = c.last;
+                c.last->next_same = item;
+                c.last = item;
+                ++c.count;
+            }
+
+            return iterator{item};
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> iterator
+        {
+            auto item = new node{std::forward<Args>(args)...};
+            link_before(header.next, item);
+
+            auto map_it = map.find(item->value);
+            if (map_it == map.end()) {
+                map.emplace(item->value, chain{item, item, 1});
+            } else {
+                auto&& c = map_it->second;
+                item->next_same = c.first;
+                c.first->prev_same = item;
+                c.first = item;
+                ++c.count;
+                map_it->first.rebind(item->value);
+            }
+
+            return iterator{item};
+        }
+
+        auto erase(const_iterator it) -> void
+        {
+            auto item = static_cast<node*>(it.at);
+            auto map_it = map.find(item->value);
+            assert(map_it != map.end());
+            erase(map_it, item);
+        }
+
+        // Erases every value equal to x, returns how many.
+        auto erase(value_type const& x) -> size_type
+        {
+            auto map_it = map.find(x);
+            if (map_it == map.end()) return 0;
+
+            auto n = map_it->second.count;
+            for (auto item = map_it->second.first; item; ) {
+                auto next = item->next_same;
+                unlink(item);
+                delete item;
+                item = next;
+            }
+            map.erase(map_it);
+            return n;
+        }
+
+        auto clear() -> void
+        {
+            map.clear();
+            for (auto at = header.next; at != &header; ) {
+                auto next = at->next;
+                delete static_cast<node*>(at);
+                at = next;
+            }
+            header.prev = header.next = &header;
+            count_all = 0;
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            map.reserve(n);
+        }
+
+        auto count(value_type const& x) const -> size_type
+        {
+            auto map_it = map.find(x);
+            return (map_it == map.end() ? 0 : map_it->second.count);
+        }
+
+        auto size() const -> size_type
+        {
+            return count_all;
+        }
+
+        auto empty() const -> bool
+        {
+            return (count_all == 0);
+        }
+
+        // The oldest value equal to x.
+        auto find(value_type const& x) const -> const_iterator
+        {
+            auto map_it = map.find(x);
+            if (map_it == map.end())
+                return end();
+            return const_iterator{map_it->second.first};
+        }
+
+        auto find(value_type const& x) -> iterator
+        {
+            auto map_it = map.find(x);
+            if (map_it == map.end())
+                return end();
+            return iterator{map_it->second.first};
+        }
+
+        // Every value equal to x, oldest first; O(1) to get, O(k) to walk.
+        auto equal_range(value_type const& x) const -> std::pair<const_equal_iterator, const_equal_iterator>
+        {
+            auto map_it = map.find(x);
+            if (map_it == map.end())
+                return {};
+            return { const_equal_iterator{map_it->second.first}, {} };
+        }
+
+        auto equal_range(value_type const& x) -> std::pair<equal_iterator, equal_iterator>
+        {
+            auto map_it = map.find(x);
+            if (map_it == map.end())
+                return {};
+            return { equal_iterator{map_it->second.first}, {} };
+        }
+
+        auto begin() -> iterator { return iterator{header.next}; }
+        auto   end() -> iterator { return iterator{&header}; }
+        auto begin() const -> const_iterator { return const_iterator{header.next}; }
+        auto   end() const -> const_iterator { return const_iterator{&header}; }
+        auto cbegin() const -> const_iterator { return begin(); }
+        auto   cend() const -> const_iterator { return end(); }
+        auto rbegin() -> reverse_iterator { return reverse_iterator{end()}; }
+        auto   rend() -> reverse_iterator { return reverse_iterator{begin()}; }
+        auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+        auto   rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+
+        // Oldest and newest entries; the multimap must not be empty.
+        auto front() -> value_type& { return *begin(); }
+        auto  back() -> value_type& { return *--end(); }
+        auto front() const -> value_type const& { return *begin(); }
+        auto  back() const -> value_type const& { return *--end(); }
+
+    private:
+        auto link_before(link* at, node* item) -> void
+        {
+            item->prev = at->prev;
+            item->next = at;
+            at->prev->next = item;
+            at->prev = item;
+            ++count_all;
+        }
+
+        auto unlink(link* item) -> void
+        {
+            item->prev->next = item->next;
+            item->next->prev = item->prev;
+            --count_all;
+        }
+
+        auto erase(map_iterator map_it, node* item) -> void
+        {
+            auto&& c = map_it->second;
+            if (c.count == 1) {
+                map.erase(map_it);
+            } else {
+                (item->prev_same ? item->prev_same->next_same : c.first) = item->next_same;
+                (item->next_same ? item->next_same->prev_same : c.last) = item->prev_same;
+                --c.count;
+                map_it->first.rebind(c.first->value);
+            }
+
+            unlink(item);
+            delete item;
+        }
+
+        auto take_list(fifo_multiset& other) -> void
+        {
+            if (other.header.next == &other.header) return;
+
+            header = other.header;
+            header.next->prev = header.prev->next = &header;
+            count_all = other.count_all;
+
+            other.header.prev = other.header.next = &other.header;
+            other.count_all = 0;
+        }
+
+        map_type map;
+        // sentinel of the circular list in insertion-order
+        link header{&header, &header};
+        size_type count_all{};
+    };
+}
@@ -0,0 +1,386 @@
+#pragma once
+// A fifo_map that also knows the position of every entry, for C++14 or above.
+//
+// On top of what `fifo_map` offers, `nth(i)` gives the i-th entry
+// in insertion-order and `rank(key)` gives the position of a key,
+// both in O(log n), no matter how many entries have been erased.
+//
+// It's an `std::list` of key/value pairs with a lookup index built using
+// `std::unordered_map`, plus a sequence number for every entry.
+// A Fenwick tree over the sequence numbers counts the entries still alive,
+// which is what turns positions into sequence numbers and back.
+// Sequence numbers are handed out again when they run out or when
+// most of them belong to erased entries, so that costs amortized O(1).
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-key-reference.hpp"
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+namespace nonstd
+{
+    template <
+        class Key
+        , class T
+        , class Hash = std::hash<Key>
+        , class Key_Equal = std::equal_to<Key>
+    >
+    struct fifo_ranked_map final
+    {
+        using key_type = Key;
+        using mapped_type = T;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+
+        using value_type = std::pair<key_type const, mapped_type>;
+        using list_type = std::list<value_type>;
+        using list_iterator = typename list_type::iterator;
+        using list_const_iterator = typename list_type::const_iterator;
+        using iterator = list_iterator;
+        using const_iterator = list_const_iterator;
+        using reverse_iterator = typename list_type::reverse_iterator;
+        using const_reverse_iterator = typename list_type::const_reverse_iterator;
+
+        using key_reference = fifo_key_reference<key_type, hasher, key_equal>;
+
+        struct key_reference_hasher final
+        {
+            auto operator () (key_reference const& kr) const -> std::size_t
+            {
+                return kr.hash();
+            }
+        };
+
+        using size_type = std::size_t;
+        // key -> sequence number
+        using map_type = std::unordered_map<key_reference, size_type, key_reference_hasher>;
+        using map_iterator = typename map_type::iterator;
+
+        // rule of five; force noexcept move constructible
+        fifo_ranked_map() = default;
+
+        fifo_ranked_map(fifo_ranked_map const& x)
+        {
+            for (auto&& kv: x)
+                emplace_back(kv);
+        }
+
+        auto operator = (fifo_ranked_map const& x) -> fifo_ranked_map&
+        {
+            clear();
+            for (auto&& kv: x)
+                emplace_back(kv);
+            return *this;
+        }
+
+        fifo_ranked_map(fifo_ranked_map&& other) noexcept
+            : map{std::move(other.map)}
+            , list{std::move(other.list)}
+            , slots{std::move(other.slots)}
+            , alive{std::move(other.alive)}
+            , head{other.head}
+            , tail{other.tail}
+        {
+            other.head = other.tail = 0;
+        }
+
+        auto operator = (fifo_ranked_map&& other) noexcept -> fifo_ranked_map&
+        {
+            map = std::move(other.map);
+            list = std::move(other.list);
+            slots = std::move(other.slots);
+            alive = std::move(other.alive);
+            head = other.head;
+            tail = other.tail;
+            other.head = other.tail = 0;
+            return *this;
+        }
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            list_type item;
+            item.emplace_back(std::forward<Args>(args)...);
+
+            auto map_it = map.find(item.front().first);
+            if (map_it != map.end())
+                return { slots[map_it->second], false };
+
+            if (tail == slots.size())
+                renumber(std::min(head, size()), std::max(size(), size_type{8}));
+
+            auto list_it = item.begin();
+            list.splice(list.end(), item);
+            map.emplace(list_it->first, tail);
+            slots[tail] = list_it;
+            alive.add(tail, 1);
+            ++tail;
+
+            return { list_it, true };
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            list_type item;
+            item.emplace_back(std::forward<Args>(args)...);
+
+            auto map_it = map.find(item.front().first);
+            if (map_it != map.end())
+                return { slots[map_it->second], false };
+
+            if (head == 0)
+                renumber(std::max(size(), size_type{8}), slots.size() - tail);
+
+            auto list_it = item.begin();
+            list.splice(list.begin(), item);
+            --head;
+            map.emplace(list_it->first, head);
+            slots[head] = list_it;
+            alive.add(head, 1);
+
+            return { list_it, true };
+        }
+
+        auto erase(list_iterator list_it) -> void
+        {
+            auto map_it = map.find(list_it->first);
+            assert(map_it != map.end());
+            erase(map_it);
+        }
+
+        auto erase(key_type const& key) -> void
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end()) return;
+            erase(map_it);
+        }
+
+        auto clear() -> void
+        {
+            map.clear();
+            list.clear();
+            slots.clear();
+            alive.assign(0);
+            head = tail = 0;
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            return map.count(key);
+        }
+
+        auto size() const -> size_type
+        {
+            return map.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return map.empty();
+        }
+
+        auto find(key_type const& key) const -> const_iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return slots[map_it->second];
+        }
+
+        auto find(key_type const& key) -> iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return slots[map_it->second];
+        }
+
+        // The i-th entry in insertion-order, or end() if there isn't one.
+        auto nth(size_type i) const -> const_iterator
+        {
+            if (i >= size()) return end();
+            return slots[alive.find_nth(i)];
+        }
+
+        auto nth(size_type i) -> iterator
+        {
+            if (i >= size()) return end();
+            return slots[alive.find_nth(i)];
+        }
+
+        // Position of key in insertion-order, or size() if there isn't one.
+        auto rank(key_type const& key) const -> size_type
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return size();
+            return alive.prefix(map_it->second);
+        }
+
+        auto at(key_type const& key) const -> mapped_type const&
+        {
+            return slots[map.at(key)]->second;
+        }
+
+        auto at(key_type const& key) -> mapped_type&
+        {
+            return slots[map.at(key)]->second;
+        }
+
+        auto operator [] (key_type const& key) -> mapped_type&
+        {
+            auto list_it = find(key);
+            if (list_it != end())
+                return list_it->second;
+
+            return emplace(key, mapped_type{}).first->second;
+        }
+
+        auto begin() -> iterator { return list.begin(); }
+        auto   end() -> iterator { return list.  end(); }
+        auto begin() const -> const_iterator { return list.begin(); }
+        auto   end() const -> const_iterator { return list.  end(); }
+        auto cbegin() const -> const_iterator { return list.cbegin(); }
+        auto   cend() const -> const_iterator { return list.  cend(); }
+        auto rbegin() -> reverse_iterator { return list.rbegin(); }
+        auto   rend() -> reverse_iterator { return list.  rend(); }
+        auto rbegin() const -> const_reverse_iterator { return list.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return list.  rend(); }
+        auto crbegin() const -> const_reverse_iterator { return list.crbegin(); }
+        auto   crend() const -> const_reverse_iterator { return list.  crend(); }
+
+        // Oldest and newest entries; the map must not be empty.
+        auto front() -> value_type& { return list.front(); }
+        auto  back() -> value_type& { return list. back(); }
+        auto front() const -> value_type const& { return list.front(); }
+        auto  back() const -> value_type const& { return list. back(); }
+
+    private:
+        // Fenwick tree of 0/1 counters, one per sequence number.
+        struct counter_tree final
+        {
+            auto assign(size_type n) -> void
+            {
+                tree.assign(n, 0);
+            }
+
+            // Build from 0/1 counters in O(n).
+            auto assign(std::vector<size_type> counters) -> void
+            {
+                tree = std::move(counters);
+                for (size_type i = 0; i < tree.size(); i++) {
+                    auto parent = (i | (i + 1));
+                    if (parent < tree.size()) tree[parent] += tree[i];
+                }
+            }
+
+            // Inverse of the O(n) build; gives back the 0/1 counters.
+            auto counters() const -> std::vector<size_type>
+            {
+                auto counters = tree;
+                for (auto i = counters.size(); i-- > 0; ) {
+                    auto parent = (i | (i + 1));
+                    if (parent < counters.size()) counters[parent] -= counters[i];
+                }
+                return counters;
+            }
+
+            auto add(size_type i, size_type delta) -> void
+            {
+                for (; i < tree.size(); i |= i + 1)
+                    tree[i] += delta;
+            }
+
+            // Sum of counters [0, i).
+            auto prefix(size_type i) const -> size_type
+            {
+                size_type sum = 0;
+                for (; i > 0; i &= i - 1)
+                    sum += tree[i - 1];
+                return sum;
+            }
+
+            // Smallest i such that prefix(i + 1) == n + 1.
+            auto find_nth(size_type n) const -> size_type
+            {
+                size_type step = 1;
+                while (step <= tree.size() / 2) step <<= 1;
+
+                size_type i = 0;
+                for (; step > 0; step >>= 1) {
+                    if (i + step <= tree.size() && tree[i + step - 1] <= n) {
+                        i += step;
+                        n -= tree[i - 1];
+                    }
+                }
+                return i;
+            }
+
+        private:
+            std::vector<size_type> tree;
+        };
+
+        auto erase(map_iterator map_it) -> void
+        {
+            auto seq = map_it->second;
+            map.erase(map_it);
+            list.erase(slots[seq]);
+            alive.add(seq, size_type(-1));
+
+            auto dead = (tail - head) - size();
+            if (dead > size() && dead > 8)
+                renumber(std::min(head, size()), std::min(slots.size() - tail, size()));
+        }
+
+        // Hand out fresh sequence numbers to the entries alive,
+        // leaving room for front_room entries before them and
+        // back_room entries after them.
+        auto renumber(size_type front_room, size_type back_room) -> void
+        {
+            auto counters = alive.counters();
+
+            std::vector<size_type> renumbered(slots.size());
+            std::vector<list_iterator> new_slots(front_room + size() + back_room);
+            std::vector<size_type> new_counters(new_slots.size(), 0);
+
+            auto seq = front_room;
+            for (auto old_seq = head; old_seq < tail; old_seq++) {
+                if (!counters[old_seq]) continue;
+                renumbered[old_seq] = seq;
+                new_slots[seq] = slots[old_seq];
+                new_counters[seq] = 1;
+                ++seq;
+            }
+
+            for (auto&& kv: map)
+                kv.second = renumbered[kv.second];
+
+            slots = std::move(new_slots);
+            alive.assign(std::move(new_counters));
+            head = front_room;
+            tail = seq;
+        }
+
+        map_type map;
+        list_type list;
+        // sequence number -> entry; slots of erased entries are never read
+        std::vector<list_iterator> slots;
+        counter_tree alive;
+        // sequence numbers in use are [head, tail)
+        size_type head{};
+        size_type tail{};
+    };
+}
@@ -2,8 +2,9 @@
 // A hash set that guarantees iteration in insertion-order for C++14 or above.
 // Or you can say, "a FIFO-ordered duplication-free container" if you feel like it.
 //
-// It's basically an `std::forward_list` of values,
+// It's basically an `std::list` of values,
 // with a lookup index built using `std::unordered_map`.
+// Iterators are bidirectional, so newest-first is just `rbegin()`.
 //
 // It's a drop-in replacement for `std::unordered_set`
 // if the interface you used was implemented.
@@ -11,11 +12,19 @@
 // Time complexity of all implemented operations are basically
 // the same as `std::unordered_map`, which should be the same as `std::unordered_set`.
 //
+// Set algebra keeps the order of the left operand, then appends
+// what's new from the right operand in its order. `subtract` only walks
+// the smaller side; everything else walks the left operand, as only it
+// knows its order, so `set_intersection(a, b)` is O(|a|) even when b is tiny.
+//
 // Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2020.
 // Licensed under the MIT License.
 
+#include "fifo-key-reference.hpp"
 #include <unordered_map>
-#include <forward_list>
+#include <list>
+#include <iterator>
+#include <algorithm>
 #include <cassert>
 
 namespace nonstd
@@ -31,31 +40,15 @@ namespace nonstd
         using hasher = Hash;
         using equal = Equal;
 
-        using list_type = std::forward_list<value_type>;
+        using list_type = std::list<value_type>;
         using list_iterator = typename list_type::iterator;
         using list_const_iterator = typename list_type::const_iterator;
         using iterator = list_iterator;
         using const_iterator = list_const_iterator;
+        using reverse_iterator = typename list_type::reverse_iterator;
+        using const_reverse_iterator = typename list_type::const_reverse_iterator;
 
-        struct value_reference final
-        {
-            value_reference(value_type const& x): x{x} {}
-
-            auto hash() const -> std::size_t
-            {
-                hasher h{};
-                return h(x);
-            }
-
-            friend auto operator == (value_reference const& a, value_reference const& b) -> bool
-            {
-                equal eq{};
-                return eq(a.x, b.x);
-            }
-
-        private:
-            value_type const& x;
-        };
+        using value_reference = fifo_key_reference<value_type, hasher, equal>;
 
         struct value_reference_hasher final
         {
@@ -89,17 +82,12 @@ namespace nonstd
         fifo_set(fifo_set&& other) noexcept
             : map{std::move(other.map)}
             , list{std::move(other.list)}
-            , list_back{(list.empty() ? list.before_begin() : other.list_back)}
-        {
-            if (!list.empty()) map.at(list.front()) = list.before_begin();
-        }
+        {}
 
         auto operator = (fifo_set&& other) noexcept -> fifo_set&
         {
             map = std::move(other.map);
             list = std::move(other.list);
-            list_back = (list.empty() ? list.before_begin() : other.list_back);
-            if (!list.empty()) map.at(list.front()) = list.before_begin();
             return *this;
         }
 
@@ -117,16 +105,11 @@ namespace nonstd
 
             auto map_it = map.find(value);
             if (map_it == map.end()) {
-                auto list_before_item = list_back;
-                list_back = list.insert_after(list_back, std::move(value));
-
-                map.emplace(*list_back, list_before_item);
-
-                return { list_back, true };
+                auto list_it = list.insert(list.end(), std::move(value));
+                map.emplace(*list_it, list_it);
+                return { list_it, true };
             } else {
-                auto list_it = map_it->second;
-                ++list_it;
-                return { list_it, false };
+                return { map_it->second, false };
             }
         }
 
@@ -137,17 +120,11 @@ namespace nonstd
 
             auto map_it = map.find(value);
             if (map_it == map.end()) {
-                auto& list_it = (empty() ? list_back : map.at(list.front()));
-                auto list_before_item = list_it;
-                list_it = list.insert_after(list_before_item, std::move(value));
-
-                map.emplace(*list_it, list_before_item);
-
+                auto list_it = list.insert(list.begin(), std::move(value));
+                map.emplace(*list_it, list_it);
                 return { list_it, true };
             } else {
-                auto list_it = map_it->second;
-                ++list_it;
-                return { list_it, false };
+                return { map_it->second, false };
             }
         }
 
@@ -156,16 +133,8 @@ namespace nonstd
             auto map_it = map.find(*list_it);
             assert(map_it != map.end());
 
-            auto list_before_item = map_it->second;
             map.erase(map_it);
-
-            list_it = list.erase_after(list_before_item);
-
-            if (list_it == list.end()) {
-                list_back = list_before_item;
-            } else {
-                map.at(*list_it) = list_before_item;
-            }
+            list.erase(list_it);
         }
 
         auto erase(value_type const& x) -> void
@@ -173,23 +142,71 @@ namespace nonstd
             auto map_it = map.find(x);
             if (map_it == map.end()) return;
 
-            auto list_before_item = map_it->second;
+            auto list_it = map_it->second;
             map.erase(map_it);
+            list.erase(list_it);
+        }
 
-            auto list_it = list.erase_after(list_before_item);
+        auto clear() -> void
+        {
+            map.clear();
+            list.clear();
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            map.reserve(n);
+        }
+
+        // this = this | x
+        auto unite_with(fifo_set const& x) -> void
+        {
+            map.reserve(size() + x.size());
+            for (auto&& v: x)
+                emplace_back(v);
+        }
 
-            if (list_it == list.end()) {
-                list_back = list_before_item;
+        // this = this & x
+        auto intersect_with(fifo_set const& x) -> void
+        {
+            if (&x == this) return;
+            for (auto list_it = list.begin(); list_it != list.end(); ) {
+                auto next = std::next(list_it);
+                if (!x.count(*list_it)) erase(list_it);
+                list_it = next;
+            }
+        }
+
+        // this = this - x
+        auto subtract(fifo_set const& x) -> void
+        {
+            if (&x == this) return clear();
+            if (x.size() < size()) {
+                for (auto&& v: x)
+                    erase(v);
             } else {
-                map.at(*list_it) = list_before_item;
+                for (auto list_it = list.begin(); list_it != list.end(); ) {
+                    auto next = std::next(list_it);
+                    if (x.count(*list_it)) erase(list_it);
+                    list_it = next;
+                }
             }
         }
 
-        auto clear() -> void
+        // this = this ^ x
+        auto symmetric_subtract(fifo_set const& x) -> void
         {
-            map.clear();
-            list.clear();
-            list_back = list.before_begin();
+            if (&x == this) return clear();
+            for (auto&& v: x) {
+                auto map_it = map.find(v);
+                if (map_it == map.end()) {
+                    emplace_back(v);
+                } else {
+                    auto list_it = map_it->second;
+                    map.erase(map_it);
+                    list.erase(list_it);
+                }
+            }
         }
 
         auto count(value_type const& x) const -> size_type
@@ -212,9 +229,7 @@ namespace nonstd
             auto map_it = map.find(x);
             if (map_it == map.end())
                 return end();
-
-            auto list_before_item = map_it->second;
-            return ++list_before_item;
+            return map_it->second;
         }
 
         auto find(value_type const& x) -> iterator
@@ -222,9 +237,7 @@ namespace nonstd
             auto map_it = map.find(x);
             if (map_it == map.end())
                 return end();
-
-            auto list_before_item = map_it->second;
-            return ++list_before_item;
+            return map_it->second;
         }
 
         auto begin() -> iterator { return list.begin(); }
@@ -233,11 +246,66 @@ namespace nonstd
         auto   end() const -> const_iterator { return list.  end(); }
         auto cbegin() const -> const_iterator { return list.cbegin(); }
         auto   cend() const -> const_iterator { return list.  cend(); }
+        auto rbegin() -> reverse_iterator { return list.rbegin(); }
+        auto   rend() -> reverse_iterator { return list.  rend(); }
+        auto rbegin() const -> const_reverse_iterator { return list.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return list.  rend(); }
+        auto crbegin() const -> const_reverse_iterator { return list.crbegin(); }
+        auto   crend() const -> const_reverse_iterator { return list.  crend(); }
+
+        // Oldest and newest values; the set must not be empty.
+        auto front() const -> value_type const& { return list.front(); }
+        auto  back() const -> value_type const& { return list. back(); }
 
     private:
         map_type map;
         list_type list;
-        list_iterator list_back{list.before_begin()};
     };
-}
 
+    template <class T, class Hash, class Equal>
+    auto set_union(fifo_set<T, Hash, Equal> const& a, fifo_set<T, Hash, Equal> const& b)
+        -> fifo_set<T, Hash, Equal>
+    {
+        fifo_set<T, Hash, Equal> result;
+        result.reserve(a.size() + b.size());
+        for (auto&& x: a) result.emplace_back(x);
+        for (auto&& x: b) result.emplace_back(x);
+        return result;
+    }
+
+    // O(|a|), in the order of a.
+    template <class T, class Hash, class Equal>
+    auto set_intersection(fifo_set<T, Hash, Equal> const& a, fifo_set<T, Hash, Equal> const& b)
+        -> fifo_set<T, Hash, Equal>
+    {
+        fifo_set<T, Hash, Equal> result;
+        result.reserve(std::min(a.size(), b.size()));
+        for (auto&& x: a)
+            if (b.count(x)) result.emplace_back(x);
+        return result;
+    }
+
+    template <class T, class Hash, class Equal>
+    auto set_difference(fifo_set<T, Hash, Equal> const& a, fifo_set<T, Hash, Equal> const& b)
+        -> fifo_set<T, Hash, Equal>
+    {
+        fifo_set<T, Hash, Equal> result;
+        result.reserve(a.size());
+        for (auto&& x: a)
+            if (!b.count(x)) result.emplace_back(x);
+        return result;
+    }
+
+    template <class T, class Hash, class Equal>
+    auto set_symmetric_difference(fifo_set<T, Hash, Equal> const& a, fifo_set<T, Hash, Equal> const& b)
+        -> fifo_set<T, Hash, Equal>
+    {
+        fifo_set<T, Hash, Equal> result;
+        result.reserve(a.size() + b.size());
+        for (auto&& x: a)
+            if (!b.count(x)) result.emplace_back(x);
+        for (auto&& x: b)
+            if (!a.count(x)) result.emplace_back(x);
+        return result;
+    }
+}
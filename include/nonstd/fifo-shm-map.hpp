@@ -0,0 +1,471 @@
+#pragma once
+// A hash map that guarantees iteration in insertion-order and lives in
+// POSIX shared memory, for C++14 or above.
+//
+// One process `create`s a named segment of a fixed capacity; any number of
+// processes on the host `open` it and share the same entries. Everything
+// is inside the segment: a header, a bucket array and an array of nodes,
+// linked by 32-bit node numbers instead of pointers, as every process maps
+// the segment at its own address. Free nodes are kept on a list of their
+// own, so there's no allocator to speak of.
+//
+// Keys and values must be trivially copyable, and Hash must give the same
+// results in every process (`std::hash` of integers does, for one build).
+// A process-shared `pthread_rwlock_t` in the header guards every operation,
+// so lookups copy values out rather than hand out references.
+//
+// If a process dies holding the lock, the others will wait forever.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#if !defined(__unix__) && !defined(__APPLE__)
+#error "fifo-shm-map.hpp needs POSIX shared memory"
+#endif
+
+#include <functional>
+#include <type_traits>
+#include <system_error>
+#include <stdexcept>
+#include <utility>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// The magic number is how other processes tell the segment is ready.
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "fifo-shm-map.hpp needs lock-free 64-bit atomics"
+#endif
+
+namespace nonstd
+{
+    namespace fifo_detail
+    {
+        [[noreturn]] inline auto throw_system_error(char const* what) -> void
+        {
+            throw std::system_error{errno, std::system_category(), what};
+        }
+
+        // Scoped read and write locks on a pthread_rwlock_t.
+        template <int (*Lock)(pthread_rwlock_t*)>
+        struct rwlock_guard final
+        {
+            explicit rwlock_guard(pthread_rwlock_t* lock): lock{lock}
+            {
+                if (auto e = Lock(lock)) throw std::system_error{e, std::system_category(), "fifo_shm_map: lock"};
+            }
+
+            ~rwlock_guard()
+            {
+                pthread_rwlock_unlock(lock);
+            }
+
+            rwlock_guard(rwlock_guard const&) = delete;
+            auto operator = (rwlock_guard const&) -> rwlock_guard& = delete;
+
+        private:
+            pthread_rwlock_t* lock;
+        };
+
+        using read_guard = rwlock_guard<pthread_rwlock_rdlock>;
+        using write_guard = rwlock_guard<pthread_rwlock_wrlock>;
+    }
+
+    template <
+        class Key
+        , class T
+        , class Hash = std::hash<Key>
+        , class Key_Equal = std::equal_to<Key>
+    >
+    struct fifo_shm_map final
+    {
+        static_assert(std::is_trivially_copyable<Key>::value, "fifo_shm_map keys must be trivially copyable");
+        static_assert(std::is_trivially_copyable<T>::value, "fifo_shm_map values must be trivially copyable");
+
+        using key_type = Key;
+        using mapped_type = T;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+        using size_type = std::uint32_t;
+
+        // Makes a new segment with room for capacity entries.
+        // Fails if one with that name exists already.
+        static auto create(char const* name, size_type capacity) -> fifo_shm_map
+        {
+            // so that bucket_count, a power of two no less than capacity, fits
+            if (capacity == 0 || capacity > (size_type(1) << 31)) throw std::length_error{"fifo_shm_map::create"};
+
+            size_type bucket_count = 8;
+            while (bucket_count < capacity) bucket_count <<= 1;
+
+            auto bytes = segment_size(bucket_count, capacity);
+            auto fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0) fifo_detail::throw_system_error("fifo_shm_map::create");
+            if (::ftruncate(fd, off_t(bytes)) < 0) {
+                auto e = errno;
+                ::close(fd);
+                ::shm_unlink(name);
+                errno = e;
+                fifo_detail::throw_system_error("fifo_shm_map::create");
+            }
+
+            try {
+                fifo_shm_map m{fd, bytes};
+                m.initialize(bucket_count, capacity);
+                return m;
+            } catch (...) {
+                ::shm_unlink(name);
+                throw;
+            }
+        }
+
+        // Maps a segment made by create, maybe in another process.
+        static auto open(char const* name) -> fifo_shm_map
+        {
+            auto fd = ::shm_open(name, O_RDWR, 0);
+            if (fd < 0) fifo_detail::throw_system_error("fifo_shm_map::open");
+
+            struct stat st;
+            if (::fstat(fd, &st) < 0) {
+                auto e = errno;
+                ::close(fd);
+                errno = e;
+                fifo_detail::throw_system_error("fifo_shm_map::open");
+            }
+            if (std::size_t(st.st_size) < sizeof(header)) {
+                ::close(fd);
+                throw std::runtime_error{"fifo_shm_map::open: not a fifo_shm_map"};
+            }
+
+            fifo_shm_map m{fd, std::size_t(st.st_size)};
+            auto&& h = m.head();
+            if (h.magic.load(std::memory_order_acquire) != magic || h.key_size != sizeof(key_type) || h.value_size != sizeof(mapped_type)
+                || segment_size(h.bucket_count, h.capacity) != m.bytes)
+                throw std::runtime_error{"fifo_shm_map::open: not a fifo_shm_map of this type"};
+            return m;
+        }
+
+        // Removes the name; processes that have it mapped keep using it.
+        static auto remove(char const* name) -> void
+        {
+            if (::shm_unlink(name) < 0) fifo_detail::throw_system_error("fifo_shm_map::remove");
+        }
+
+        fifo_shm_map(fifo_shm_map const&) = delete;
+        auto operator = (fifo_shm_map const&) -> fifo_shm_map& = delete;
+
+        fifo_shm_map(fifo_shm_map&& other) noexcept
+            : base{other.base}
+            , bytes{other.bytes}
+        {
+            other.base = nullptr;
+            other.bytes = 0;
+        }
+
+        auto operator = (fifo_shm_map&& other) noexcept -> fifo_shm_map&
+        {
+            if (this != &other) {
+                unmap();
+                base = other.base;
+                bytes = other.bytes;
+                other.base = nullptr;
+                other.bytes = 0;
+            }
+            return *this;
+        }
+
+        // Unmaps; the entries stay in the segment.
+        ~fifo_shm_map()
+        {
+            unmap();
+        }
+
+        // For interface compatibility with std::unordered_map.
+        auto emplace(key_type const& key, mapped_type const& x) -> bool
+        {
+            return emplace_back(key, x);
+        }
+
+        // Whether it was inserted; throws std::length_error if full.
+        auto emplace_back(key_type const& key, mapped_type const& x) -> bool
+        {
+            fifo_detail::write_guard lock{&head().lock};
+            return insert(key, x, false);
+        }
+
+        auto emplace_front(key_type const& key, mapped_type const& x) -> bool
+        {
+            fifo_detail::write_guard lock{&head().lock};
+            return insert(key, x, true);
+        }
+
+        // Assigns if key is there, keeping its place; otherwise inserts at the back.
+        auto insert_or_assign(key_type const& key, mapped_type const& x) -> bool
+        {
+            fifo_detail::write_guard lock{&head().lock};
+
+            auto i = find_node(hash_of(key), key);
+            if (i == npos) return insert(key, x, false);
+
+            node_at(i).value = x;
+            return false;
+        }
+
+        // Whether it was there.
+        auto erase(key_type const& key) -> bool
+        {
+            fifo_detail::write_guard lock{&head().lock};
+
+            auto&& h = head();
+            auto hash = hash_of(key);
+            auto at = &bucket_at(bucket_of(hash));
+            while (*at != npos) {
+                auto&& n = node_at(*at);
+                if (n.hash == hash && key_equal{}(n.key, key)) {
+                    auto i = *at;
+                    *at = n.chain;
+                    (n.prev == npos ? h.first : node_at(n.prev).next) = n.next;
+                    (n.next == npos ? h.last : node_at(n.next).prev) = n.prev;
+                    n.next = h.free;
+                    h.free = i;
+                    --h.count;
+                    return true;
+                }
+                at = &n.chain;
+            }
+            return false;
+        }
+
+        auto clear() -> void
+        {
+            fifo_detail::write_guard lock{&head().lock};
+            reset();
+        }
+
+        // Copies the value of key into x; whether it was there.
+        auto find(key_type const& key, mapped_type& x) const -> bool
+        {
+            fifo_detail::read_guard lock{&head().lock};
+
+            auto i = find_node(hash_of(key), key);
+            if (i == npos) return false;
+            x = node_at(i).value;
+            return true;
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            fifo_detail::read_guard lock{&head().lock};
+            return (find_node(hash_of(key), key) == npos ? 0 : 1);
+        }
+
+        // Calls f(key, value) for every entry in insertion-order, holding
+        // the read lock throughout; f must not call back into the map.
+        template <class F>
+        auto for_each(F&& f) const -> void
+        {
+            fifo_detail::read_guard lock{&head().lock};
+            for (auto i = head().first; i != npos; i = node_at(i).next) {
+                auto&& n = node_at(i);
+                f(n.key, n.value);
+            }
+        }
+
+        auto size() const -> size_type
+        {
+            fifo_detail::read_guard lock{&head().lock};
+            return head().count;
+        }
+
+        auto empty() const -> bool
+        {
+            return (size() == 0);
+        }
+
+        auto capacity() const -> size_type
+        {
+            return head().capacity;
+        }
+
+    private:
+        static constexpr size_type npos = size_type(-1);
+        static constexpr unsigned long long magic = 0x70616d2d6f666966ull;    // "fifo-map"
+
+        struct header final
+        {
+            // set last, with release, once the rest is ready
+            std::atomic<unsigned long long> magic;
+            std::uint32_t key_size;
+            std::uint32_t value_size;
+            size_type capacity;
+            size_type bucket_count;
+            // 64 - log2(bucket_count)
+            std::uint32_t shift;
+            size_type count;
+            // ends of the insertion-order list, and the free list
+            size_type first;
+            size_type last;
+            size_type free;
+            pthread_rwlock_t lock;
+        };
+
+        struct node final
+        {
+            key_type key;
+            mapped_type value;
+            std::uint64_t hash;
+            // neighbors in insertion-order; next also links the free list
+            size_type prev;
+            size_type next;
+            // next in the same bucket
+            size_type chain;
+        };
+
+        static auto align_up(std::size_t n, std::size_t a) -> std::size_t
+        {
+            return (n + a - 1) / a * a;
+        }
+
+        static auto buckets_offset() -> std::size_t
+        {
+            return align_up(sizeof(header), alignof(size_type));
+        }
+
+        static auto nodes_offset(size_type bucket_count) -> std::size_t
+        {
+            return align_up(buckets_offset() + bucket_count * sizeof(size_type), alignof(node));
+        }
+
+        static auto segment_size(size_type bucket_count, size_type capacity) -> std::size_t
+        {
+            return nodes_offset(bucket_count) + std::size_t(capacity) * sizeof(node);
+        }
+
+        static auto hash_of(key_type const& key) -> std::uint64_t
+        {
+            hasher h{};
+            return h(key);
+        }
+
+        // Takes over fd.
+        fifo_shm_map(int fd, std::size_t bytes): bytes{bytes}
+        {
+            auto p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            auto e = errno;
+            ::close(fd);
+            if (p == MAP_FAILED) {
+                errno = e;
+                fifo_detail::throw_system_error("fifo_shm_map: mmap");
+            }
+            base = static_cast<unsigned char*>(p);
+        }
+
+        auto unmap() -> void
+        {
+            if (base) ::munmap(base, bytes);
+            base = nullptr;
+        }
+
+        auto initialize(size_type bucket_count, size_type capacity) -> void
+        {
+            auto&& h = head();
+            h.key_size = sizeof(key_type);
+            h.value_size = sizeof(mapped_type);
+            h.capacity = capacity;
+            h.bucket_count = bucket_count;
+            h.shift = 64;
+            while (bucket_count >>= 1) --h.shift;
+
+            pthread_rwlockattr_t attr;
+            if (auto e = pthread_rwlockattr_init(&attr))
+                throw std::system_error{e, std::system_category(), "fifo_shm_map::create"};
+            auto e = pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+            if (!e) e = pthread_rwlock_init(&h.lock, &attr);
+            pthread_rwlockattr_destroy(&attr);
+            if (e) throw std::system_error{e, std::system_category(), "fifo_shm_map::create"};
+
+            reset();
+            // last, so open() can't see a half made segment as good
+            h.magic.store(magic, std::memory_order_release);
+        }
+
+        auto reset() -> void
+        {
+            auto&& h = head();
+            for (size_type i = 0; i < h.bucket_count; ++i)
+                bucket_at(i) = npos;
+            for (size_type i = 0; i < h.capacity; ++i)
+                node_at(i).next = (i + 1 < h.capacity ? i + 1 : npos);
+
+            h.count = 0;
+            h.first = h.last = npos;
+            h.free = 0;
+        }
+
+        auto head() const -> header& { return *reinterpret_cast<header*>(base); }
+        auto bucket_at(size_type i) const -> size_type& { return reinterpret_cast<size_type*>(base + buckets_offset())[i]; }
+        auto node_at(size_type i) const -> node& { return reinterpret_cast<node*>(base + nodes_offset(head().bucket_count))[i]; }
+
+        // Fibonacci hashing; std::hash of integers is usually the identity.
+        auto bucket_of(std::uint64_t hash) const -> size_type
+        {
+            return size_type((hash * 0x9E3779B97F4A7C15ull) >> head().shift);
+        }
+
+        auto find_node(std::uint64_t hash, key_type const& key) const -> size_type
+        {
+            key_equal eq{};
+            for (auto i = bucket_at(bucket_of(hash)); i != npos; i = node_at(i).chain) {
+                auto&& n = node_at(i);
+                if (n.hash == hash && eq(n.key, key)) return i;
+            }
+            return npos;
+        }
+
+        // With the write lock held.
+        auto insert(key_type const& key, mapped_type const& x, bool at_front) -> bool
+        {
+            auto hash = hash_of(key);
+            if (find_node(hash, key) != npos) return false;
+
+            auto&& h = head();
+            if (h.free == npos) throw std::length_error{"fifo_shm_map: full"};
+
+            auto i = h.free;
+            auto&& n = node_at(i);
+            h.free = n.next;
+
+            n.key = key;
+            n.value = x;
+            n.hash = hash;
+
+            auto&& b = bucket_at(bucket_of(hash));
+            n.chain = b;
+            b = i;
+
+            if (at_front) {
+                n.prev = npos;
+                n.next = h.first;
+                (h.first == npos ? h.last : node_at(h.first).prev) = i;
+                h.first = i;
+            } else {
+                n.prev = h.last;
+                n.next = npos;
+                (h.last == npos ? h.first : node_at(h.last).next) = i;
+                h.last = i;
+            }
+            ++h.count;
+            return true;
+        }
+
+        unsigned char* base{};
+        std::size_t bytes{};
+    };
+}
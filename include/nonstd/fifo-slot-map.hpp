@@ -0,0 +1,498 @@
+#pragma once
+// A hash map that guarantees iteration in insertion-order and hands out
+// compact handles to its entries, for C++14 or above.
+//
+// Every entry lives in a slot of a chunked slot array, and a 32-bit
+// `fifo_slot_handle` names it by slot index plus a generation tag.
+// `resolve(handle)` is one array access, no hashing, and gives end()
+// if the entry has been erased since; handles survive copies of the map,
+// and can be stored as plain integers.
+//
+// Insertion-order is a doubly linked list threaded through the slots by
+// index, and the lookup index is built using `std::unordered_map`.
+// Slots of erased entries are reused first-in-first-out, each time with a
+// new generation; a slot whose 8-bit generation has run out is retired
+// instead, so a stale handle never resolves.
+//
+// So each slot serves 256 entries, and the 2^24 slots about 2^32 insertions
+// over the map's life, after which `emplace` throws std::length_error even
+// if the map is nearly empty. Long-running programs that churn entries
+// should call `reset_generations` now and then, at a point where they hold
+// no handles of erased entries; it puts retired slots back in use.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-key-reference.hpp"
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdint>
+#include <cassert>
+
+namespace nonstd
+{
+    struct fifo_slot_handle final
+    {
+        static constexpr std::uint32_t index_bits = 24;
+        static constexpr std::uint32_t index_mask = (std::uint32_t(1) << index_bits) - 1;
+
+        // Null handle, never resolves.
+        fifo_slot_handle() = default;
+        explicit fifo_slot_handle(std::uint32_t raw): raw{raw} {}
+        fifo_slot_handle(std::uint32_t index, std::uint32_t generation)
+            : raw{(generation << index_bits) | (index & index_mask)}
+        {}
+
+        auto value() const -> std::uint32_t { return raw; }
+        auto index() const -> std::uint32_t { return (raw & index_mask); }
+        auto generation() const -> std::uint32_t { return (raw >> index_bits); }
+
+        friend auto operator == (fifo_slot_handle a, fifo_slot_handle b) -> bool { return a.raw == b.raw; }
+        friend auto operator != (fifo_slot_handle a, fifo_slot_handle b) -> bool { return a.raw != b.raw; }
+
+    private:
+        std::uint32_t raw{~std::uint32_t{}};
+    };
+
+    template <
+        class Key
+        , class T
+        , class Hash = std::hash<Key>
+        , class Key_Equal = std::equal_to<Key>
+    >
+    struct fifo_slot_map final
+    {
+        using key_type = Key;
+        using mapped_type = T;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+
+        using value_type = std::pair<key_type const, mapped_type>;
+        using handle_type = fifo_slot_handle;
+
+        using key_reference = fifo_key_reference<key_type, hasher, key_equal>;
+
+        struct key_reference_hasher final
+        {
+            auto operator () (key_reference const& kr) const -> std::size_t
+            {
+                return kr.hash();
+            }
+        };
+
+        using slot_index = std::uint32_t;
+        using map_type = std::unordered_map<key_reference, slot_index, key_reference_hasher>;
+        using map_iterator = typename map_type::iterator;
+        using size_type = typename map_type::size_type;
+
+        template <bool Const>
+        struct basic_iterator final
+        {
+            using owner_type = std::conditional_t<Const, fifo_slot_map const, fifo_slot_map>;
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = fifo_slot_map::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, value_type const*, value_type*>;
+            using reference = std::conditional_t<Const, value_type const&, value_type&>;
+
+            basic_iterator() = default;
+            basic_iterator(owner_type* owner, slot_index i): owner{owner}, i{i} {}
+
+            // iterator -> const_iterator
+            template <bool Other, class = std::enable_if_t<Const && !Other>>
+            basic_iterator(basic_iterator<Other> const& x): owner{x.owner}, i{x.i} {}
+
+            auto operator *  () const -> reference { return owner->slot_at(i).value(); }
+            auto operator -> () const -> pointer { return &owner->slot_at(i).value(); }
+
+            auto operator ++ () -> basic_iterator&
+            {
+                i = owner->slot_at(i).next;
+                return *this;
+            }
+
+            auto operator -- () -> basic_iterator&
+            {
+                i = (i == npos ? owner->tail : owner->slot_at(i).prev);
+                return *this;
+            }
+
+            auto operator ++ (int) -> basic_iterator { auto x = *this; ++*this; return x; }
+            auto operator -- (int) -> basic_iterator { auto x = *this; --*this; return x; }
+
+            friend auto operator == (basic_iterator const& a, basic_iterator const& b) -> bool { return a.i == b.i; }
+            friend auto operator != (basic_iterator const& a, basic_iterator const& b) -> bool { return a.i != b.i; }
+
+        private:
+            friend fifo_slot_map;
+            owner_type* owner{};
+            slot_index i{npos};
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        // rule of five; force noexcept move constructible
+        fifo_slot_map() = default;
+
+        // Copies keep the slots, so handles of x resolve in the copy too.
+        fifo_slot_map(fifo_slot_map const& x)
+        {
+            copy_slots(x);
+        }
+
+        auto operator = (fifo_slot_map const& x) -> fifo_slot_map&
+        {
+            if (this != &x) {
+                release();
+                copy_slots(x);
+            }
+            return *this;
+        }
+
+        fifo_slot_map(fifo_slot_map&& other) noexcept
+            : map{std::move(other.map)}
+            , chunks{std::move(other.chunks)}
+            , slot_count{other.slot_count}
+            , head{other.head}
+            , tail{other.tail}
+            , free_head{other.free_head}
+            , free_tail{other.free_tail}
+        {
+            other.forget();
+        }
+
+        auto operator = (fifo_slot_map&& other) noexcept -> fifo_slot_map&
+        {
+            if (this != &other) {
+                release();
+                map = std::move(other.map);
+                chunks = std::move(other.chunks);
+                slot_count = other.slot_count;
+                head = other.head;
+                tail = other.tail;
+                free_head = other.free_head;
+                free_tail = other.free_tail;
+                other.forget();
+            }
+            return *this;
+        }
+
+        ~fifo_slot_map()
+        {
+            release();
+        }
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto map_it = map.find(value.first);
+            if (map_it != map.end())
+                return { iterator{this, map_it->second}, false };
+
+            auto i = acquire(std::move(value));
+            link_after(tail, i);
+            map.emplace(slot_at(i).value().first, i);
+
+            return { iterator{this, i}, true };
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto map_it = map.find(value.first);
+            if (map_it != map.end())
+                return { iterator{this, map_it->second}, false };
+
+            auto i = acquire(std::move(value));
+            link_after(npos, i);
+            map.emplace(slot_at(i).value().first, i);
+
+            return { iterator{this, i}, true };
+        }
+
+        auto erase(const_iterator it) -> void
+        {
+            auto map_it = map.find(it->first);
+            assert(map_it != map.end());
+            erase(map_it);
+        }
+
+        auto erase(key_type const& key) -> void
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end()) return;
+            erase(map_it);
+        }
+
+        // Erases every entry; all handles become stale. Retired slots stay
+        // retired, as old handles may still be around; see reset_generations.
+        auto clear() -> void
+        {
+            while (head != npos)
+                erase(const_iterator{this, head});
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            return map.count(key);
+        }
+
+        auto size() const -> size_type
+        {
+            return map.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return map.empty();
+        }
+
+        auto find(key_type const& key) const -> const_iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return { this, map_it->second };
+        }
+
+        auto find(key_type const& key) -> iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return { this, map_it->second };
+        }
+
+        auto at(key_type const& key) const -> mapped_type const&
+        {
+            return slot_at(map.at(key)).value().second;
+        }
+
+        auto at(key_type const& key) -> mapped_type&
+        {
+            return slot_at(map.at(key)).value().second;
+        }
+
+        auto operator [] (key_type const& key) -> mapped_type&
+        {
+            auto it = find(key);
+            if (it != end())
+                return it->second;
+
+            return emplace(key, mapped_type{}).first->second;
+        }
+
+        // Puts every slot not in use back in the free queue, from generation
+        // 0. Handles of entries still there keep resolving, but a handle of
+        // an erased entry may resolve to a new one afterwards, so drop those
+        // first. O(number of slots ever used).
+        auto reset_generations() -> void
+        {
+            free_head = free_tail = npos;
+            for (slot_index i = 0; i < slot_count; i++) {
+                auto&& s = slot_at(i);
+                if (s.live) continue;
+                s.generation = 0;
+                push_free(i);
+            }
+        }
+
+        // O(1), no hashing.
+        auto handle_of(const_iterator it) const -> handle_type
+        {
+            return { it.i, slot_at(it.i).generation };
+        }
+
+        // O(1), no hashing; end() if the entry is gone.
+        auto resolve(handle_type h) const -> const_iterator
+        {
+            return { this, resolve_index(h) };
+        }
+
+        auto resolve(handle_type h) -> iterator
+        {
+            return { this, resolve_index(h) };
+        }
+
+        auto begin() -> iterator { return { this, head }; }
+        auto   end() -> iterator { return { this, npos }; }
+        auto begin() const -> const_iterator { return { this, head }; }
+        auto   end() const -> const_iterator { return { this, npos }; }
+        auto cbegin() const -> const_iterator { return begin(); }
+        auto   cend() const -> const_iterator { return end(); }
+        auto rbegin() -> reverse_iterator { return reverse_iterator{end()}; }
+        auto   rend() -> reverse_iterator { return reverse_iterator{begin()}; }
+        auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+        auto   rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+
+    private:
+        static constexpr slot_index npos = ~slot_index{};
+        // The null handle's index must never name a slot.
+        static constexpr slot_index max_slots = fifo_slot_handle::index_mask;
+        static constexpr slot_index chunk_bits = 10;
+        static constexpr slot_index chunk_size = slot_index(1) << chunk_bits;
+        // A handle carries 8 bits of generation.
+        static constexpr std::uint8_t last_generation = 0xff;
+
+        struct slot final
+        {
+            auto value() -> value_type& { return *reinterpret_cast<value_type*>(storage); }
+            auto value() const -> value_type const& { return *reinterpret_cast<value_type const*>(storage); }
+
+            alignas(value_type) unsigned char storage[sizeof(value_type)];
+            // neighbors in insertion-order, or in the free queue
+            slot_index prev{npos};
+            slot_index next{npos};
+            std::uint8_t generation{};
+            bool live{};
+        };
+
+        auto slot_at(slot_index i) -> slot& { return chunks[i >> chunk_bits][i & (chunk_size - 1)]; }
+        auto slot_at(slot_index i) const -> slot const& { return chunks[i >> chunk_bits][i & (chunk_size - 1)]; }
+
+        auto resolve_index(handle_type h) const -> slot_index
+        {
+            auto i = h.index();
+            if (i >= slot_count) return npos;
+
+            auto&& s = slot_at(i);
+            return (s.live && s.generation == h.generation() ? i : npos);
+        }
+
+        // Take the oldest free slot, or a new one.
+        auto acquire(value_type&& value) -> slot_index
+        {
+            slot_index i;
+            if (free_head != npos) {
+                i = free_head;
+                free_head = slot_at(i).next;
+                if (free_head == npos) free_tail = npos;
+            } else {
+                if (slot_count == max_slots)
+                    throw std::length_error{"fifo_slot_map: out of slots"};
+                if ((slot_count & (chunk_size - 1)) == 0)
+                    chunks.emplace_back(new slot[chunk_size]);
+                i = slot_count++;
+            }
+
+            auto&& s = slot_at(i);
+            new (s.storage) value_type{std::move(value)};
+            s.live = true;
+            return i;
+        }
+
+        // Insert slot i into insertion-order after slot `before`,
+        // or at the front if `before` is npos.
+        auto link_after(slot_index before, slot_index i) -> void
+        {
+            auto after = (before == npos ? head : slot_at(before).next);
+            auto&& s = slot_at(i);
+            s.prev = before;
+            s.next = after;
+            (before == npos ? head : slot_at(before).next) = i;
+            (after == npos ? tail : slot_at(after).prev) = i;
+        }
+
+        auto erase(map_iterator map_it) -> void
+        {
+            auto i = map_it->second;
+            map.erase(map_it);
+
+            auto&& s = slot_at(i);
+            (s.prev == npos ? head : slot_at(s.prev).next) = s.next;
+            (s.next == npos ? tail : slot_at(s.next).prev) = s.prev;
+
+            s.value().~value_type();
+            s.live = false;
+
+            // Retire the slot rather than let its generation wrap around.
+            if (s.generation == last_generation) {
+                s.prev = s.next = npos;
+                return;
+            }
+            ++s.generation;
+            push_free(i);
+        }
+
+        // Append slot i to the free queue.
+        auto push_free(slot_index i) -> void
+        {
+            auto&& s = slot_at(i);
+            s.prev = free_tail;
+            s.next = npos;
+            (free_tail == npos ? free_head : slot_at(free_tail).next) = i;
+            free_tail = i;
+        }
+
+        auto copy_slots(fifo_slot_map const& x) -> void
+        {
+            for (slot_index c = 0; c < x.chunks.size(); c++)
+                chunks.emplace_back(new slot[chunk_size]);
+
+            for (slot_index i = 0; i < x.slot_count; i++) {
+                auto&& from = x.slot_at(i);
+                auto&& to = slot_at(i);
+                if (from.live) new (to.storage) value_type{from.value()};
+                to.prev = from.prev;
+                to.next = from.next;
+                to.generation = from.generation;
+                to.live = from.live;
+                slot_count = i + 1;
+            }
+
+            head = x.head;
+            tail = x.tail;
+            free_head = x.free_head;
+            free_tail = x.free_tail;
+
+            map.reserve(x.size());
+            for (auto i = head; i != npos; i = slot_at(i).next)
+                map.emplace(slot_at(i).value().first, i);
+        }
+
+        // Destroy every entry and give back every slot.
+        auto release() -> void
+        {
+            for (slot_index i = 0; i < slot_count; i++) {
+                auto&& s = slot_at(i);
+                if (s.live) s.value().~value_type();
+            }
+            forget();
+        }
+
+        auto forget() -> void
+        {
+            map.clear();
+            chunks.clear();
+            slot_count = 0;
+            head = tail = free_head = free_tail = npos;
+        }
+
+        map_type map;
+        std::vector<std::unique_ptr<slot[]>> chunks;
+        slot_index slot_count{};
+        slot_index head{npos};
+        slot_index tail{npos};
+        // erased slots, oldest first
+        slot_index free_head{npos};
+        slot_index free_tail{npos};
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+// Writes a consistent snapshot of a `fifo_versioned_map` to a file while
+// other threads keep changing the map, for C++14 or above.
+//
+// Run `fifo_write_snapshot` on a background thread. Writers must hold the
+// same mutex for every mutation of the map. The snapshot is of the version
+// current when it starts; writers pause only while a batch of entries is
+// encoded into memory, never for the file writes, which go out in big
+// chunks with the lock released.
+//
+//      std::thread saver{[&] {
+//          nonstd::fifo_write_snapshot(map, mutex, file, nonstd::fifo_raw_encoder{});
+//      }};
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-versioned-map.hpp"
+#include <string>
+#include <mutex>
+#include <system_error>
+#include <type_traits>
+#include <cstdio>
+#include <cerrno>
+
+namespace nonstd
+{
+    // Appends the bytes of key and value, for trivially copyable ones.
+    struct fifo_raw_encoder final
+    {
+        template <class Key, class T>
+        auto operator () (std::string& buffer, Key const& key, T const& x) const -> void
+        {
+            static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                "fifo_raw_encoder needs trivially copyable keys and values");
+            buffer.append(reinterpret_cast<char const*>(&key), sizeof(key));
+            buffer.append(reinterpret_cast<char const*>(&x), sizeof(x));
+        }
+    };
+
+    namespace fifo_detail
+    {
+        // fwrite needn't set errno; report EIO rather than "Success".
+        [[noreturn]] inline auto throw_write_error() -> void
+        {
+            auto e = errno;
+            throw std::system_error{(e ? e : EIO), std::generic_category(), "fifo_write_snapshot"};
+        }
+    }
+
+    // Encodes every entry of map as of now with encode(buffer, key, value),
+    // in insertion-order, and writes them to out. Returns the version written.
+    // Throws std::system_error if writing fails.
+    template <class Map, class Mutex, class Encode>
+    auto fifo_write_snapshot(
+        Map& map
+        , Mutex& mutex
+        , std::FILE* out
+        , Encode encode
+        , typename Map::size_type batch_size = 4096
+        , std::size_t flush_bytes = 1 << 20
+    ) -> typename Map::version_type
+    {
+        std::string buffer;
+        buffer.reserve(flush_bytes * 2);
+
+        auto flush = [&] {
+            if (buffer.empty()) return;
+            errno = 0;
+            if (std::fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size())
+                fifo_detail::throw_write_error();
+            buffer.clear();
+        };
+
+        typename Map::version_type version;
+        {
+            std::lock_guard<Mutex> lock{mutex};
+            version = map.hold_snapshot();
+        }
+
+        auto more = true;
+        try {
+            while (more) {
+                {
+                    std::lock_guard<Mutex> lock{mutex};
+                    more = map.snapshot_batch(batch_size, [&] (auto&& key, auto&& x) {
+                        encode(buffer, key, x);
+                    });
+                }
+                if (buffer.size() >= flush_bytes) flush();
+            }
+            flush();
+            errno = 0;
+            if (std::fflush(out))
+                fifo_detail::throw_write_error();
+        } catch (...) {
+            if (more) {
+                std::lock_guard<Mutex> lock{mutex};
+                map.release_snapshot();
+            }
+            throw;
+        }
+        return version;
+    }
+}
@@ -0,0 +1,317 @@
+#pragma once
+// A hash map that keeps its keys and its values in two separate contiguous
+// arrays, in insertion-order, for C++14 or above.
+//
+// Same as `fifo_dense_map`, but structure-of-arrays: lookups only touch the
+// index and the keys, never the values, and `values()` is a plain contiguous
+// span that compilers can vectorize over. Handy when values are big.
+//
+// Since a key and its value are not next to each other in memory,
+// dereferencing an iterator gives a `std::pair<Key const&, T&>` by value,
+// much like `std::vector<bool>` gives a proxy.
+// Erase and emplace_front are O(n).
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "detail/position-index.hpp"
+#include <vector>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+namespace nonstd
+{
+    namespace fifo_detail
+    {
+        template <class T>
+        struct span final
+        {
+            using element_type = T;
+            using iterator = T*;
+            using size_type = std::size_t;
+
+            span(T* first, size_type n): first{first}, n{n} {}
+
+            auto begin() const -> iterator { return first; }
+            auto   end() const -> iterator { return first + n; }
+            auto data() const -> T* { return first; }
+            auto size() const -> size_type { return n; }
+            auto empty() const -> bool { return n == 0; }
+            auto operator [] (size_type i) const -> T& { return first[i]; }
+
+        private:
+            T* first;
+            size_type n;
+        };
+    }
+
+    template <
+        class Key
+        , class T
+        , class Hash = std::hash<Key>
+        , class Key_Equal = std::equal_to<Key>
+    >
+    struct fifo_soa_map final
+    {
+        // `std::vector<bool>` isn't an array of bools.
+        static_assert(!std::is_same<std::remove_cv_t<T>, bool>::value, "fifo_soa_map can't hold bool values; use char");
+        static_assert(!std::is_same<std::remove_cv_t<Key>, bool>::value, "fifo_soa_map can't have bool keys; use char");
+
+        using key_type = Key;
+        using mapped_type = T;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+
+        using value_type = std::pair<key_type, mapped_type>;
+        using index_type = fifo_detail::position_index;
+        using size_type = typename index_type::size_type;
+
+        template <class Mapped>
+        struct basic_iterator final
+        {
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = fifo_soa_map::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::pair<key_type const&, Mapped&>;
+
+            struct pointer final
+            {
+                auto operator -> () -> reference* { return &r; }
+                reference r;
+            };
+
+            basic_iterator() = default;
+            basic_iterator(key_type const* k, Mapped* v): k{k}, v{v} {}
+
+            // iterator -> const_iterator
+            template <class Other, class = std::enable_if_t<std::is_convertible<Other*, Mapped*>::value>>
+            basic_iterator(basic_iterator<Other> const& x): k{x.key()}, v{x.value()} {}
+
+            auto operator *  () const -> reference { return { *k, *v }; }
+            auto operator -> () const -> pointer { return { **this }; }
+            auto operator [] (difference_type n) const -> reference { return { k[n], v[n] }; }
+
+            auto key() const -> key_type const* { return k; }
+            auto value() const -> Mapped* { return v; }
+
+            auto operator ++ () -> basic_iterator& { ++k; ++v; return *this; }
+            auto operator -- () -> basic_iterator& { --k; --v; return *this; }
+            auto operator ++ (int) -> basic_iterator { auto x = *this; ++*this; return x; }
+            auto operator -- (int) -> basic_iterator { auto x = *this; --*this; return x; }
+            auto operator += (difference_type n) -> basic_iterator& { k += n; v += n; return *this; }
+            auto operator -= (difference_type n) -> basic_iterator& { k -= n; v -= n; return *this; }
+
+            friend auto operator + (basic_iterator it, difference_type n) -> basic_iterator { return it += n; }
+            friend auto operator + (difference_type n, basic_iterator it) -> basic_iterator { return it += n; }
+            friend auto operator - (basic_iterator it, difference_type n) -> basic_iterator { return it -= n; }
+            friend auto operator - (basic_iterator const& a, basic_iterator const& b) -> difference_type { return a.k - b.k; }
+
+            friend auto operator == (basic_iterator const& a, basic_iterator const& b) -> bool { return a.k == b.k; }
+            friend auto operator != (basic_iterator const& a, basic_iterator const& b) -> bool { return a.k != b.k; }
+            friend auto operator <  (basic_iterator const& a, basic_iterator const& b) -> bool { return a.k <  b.k; }
+            friend auto operator >  (basic_iterator const& a, basic_iterator const& b) -> bool { return a.k >  b.k; }
+            friend auto operator <= (basic_iterator const& a, basic_iterator const& b) -> bool { return a.k <= b.k; }
+            friend auto operator >= (basic_iterator const& a, basic_iterator const& b) -> bool { return a.k >= b.k; }
+
+        private:
+            key_type const* k{};
+            Mapped* v{};
+        };
+
+        using iterator = basic_iterator<mapped_type>;
+        using const_iterator = basic_iterator<mapped_type const>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        using key_span = fifo_detail::span<key_type const>;
+        using value_span = fifo_detail::span<mapped_type>;
+        using const_value_span = fifo_detail::span<mapped_type const>;
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto hash = hash_of(value.first);
+            auto position = find_position(hash, value.first);
+            if (position != index_type::npos)
+                return { begin() + position, false };
+
+            index.reserve(size() + 1);
+            key_array.push_back(std::move(value.first));
+            try {
+                value_array.push_back(std::move(value.second));
+            } catch (...) {
+                // keep keys and values in step
+                key_array.pop_back();
+                throw;
+            }
+            index.insert(hash, size() - 1);
+
+            return { end() - 1, true };
+        }
+
+        // O(n), every entry moves.
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto hash = hash_of(value.first);
+            auto position = find_position(hash, value.first);
+            if (position != index_type::npos)
+                return { begin() + position, false };
+
+            index.reserve(size() + 1);
+            key_array.insert(key_array.begin(), std::move(value.first));
+            try {
+                value_array.insert(value_array.begin(), std::move(value.second));
+            } catch (...) {
+                key_array.erase(key_array.begin());
+                throw;
+            }
+            index.shift_up_from(0);
+            index.insert(hash, 0);
+
+            return { begin(), true };
+        }
+
+        // O(n), every entry after it moves.
+        auto erase(const_iterator it) -> void
+        {
+            auto position = size_type(it - cbegin());
+            index.erase(hash_of(key_array[position]), position);
+            index.shift_down_after(position);
+            key_array.erase(key_array.begin() + position);
+            value_array.erase(value_array.begin() + position);
+        }
+
+        auto erase(key_type const& key) -> void
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos) return;
+            erase(cbegin() + position);
+        }
+
+        auto clear() -> void
+        {
+            index.clear();
+            key_array.clear();
+            value_array.clear();
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            index.reserve(n);
+            key_array.reserve(n);
+            value_array.reserve(n);
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            return (find_position(hash_of(key), key) == index_type::npos ? 0 : 1);
+        }
+
+        auto size() const -> size_type
+        {
+            return key_array.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return key_array.empty();
+        }
+
+        auto find(key_type const& key) const -> const_iterator
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos)
+                return end();
+            return begin() + position;
+        }
+
+        auto find(key_type const& key) -> iterator
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos)
+                return end();
+            return begin() + position;
+        }
+
+        // The i-th entry in insertion-order, or end() if there isn't one.
+        auto nth(size_type i) const -> const_iterator { return (i < size() ? begin() + i : end()); }
+        auto nth(size_type i) -> iterator { return (i < size() ? begin() + i : end()); }
+
+        // Position of key in insertion-order, or size() if there isn't one.
+        auto rank(key_type const& key) const -> size_type
+        {
+            auto position = find_position(hash_of(key), key);
+            return (position == index_type::npos ? size() : position);
+        }
+
+        auto at(key_type const& key) const -> mapped_type const&
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos) throw std::out_of_range{"fifo_soa_map::at"};
+            return value_array[position];
+        }
+
+        auto at(key_type const& key) -> mapped_type&
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos) throw std::out_of_range{"fifo_soa_map::at"};
+            return value_array[position];
+        }
+
+        auto operator [] (key_type const& key) -> mapped_type&
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position != index_type::npos)
+                return value_array[position];
+
+            return emplace(key, mapped_type{}).first->second;
+        }
+
+        auto keys() const -> key_span { return { key_array.data(), size() }; }
+        auto values() -> value_span { return { value_array.data(), size() }; }
+        auto values() const -> const_value_span { return { value_array.data(), size() }; }
+
+        auto begin() -> iterator { return { key_array.data(), value_array.data() }; }
+        auto   end() -> iterator { return begin() + size(); }
+        auto begin() const -> const_iterator { return { key_array.data(), value_array.data() }; }
+        auto   end() const -> const_iterator { return begin() + size(); }
+        auto cbegin() const -> const_iterator { return begin(); }
+        auto   cend() const -> const_iterator { return end(); }
+        auto rbegin() -> reverse_iterator { return reverse_iterator{end()}; }
+        auto   rend() -> reverse_iterator { return reverse_iterator{begin()}; }
+        auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+        auto   rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+
+    private:
+        static auto hash_of(key_type const& key) -> std::size_t
+        {
+            hasher h{};
+            return h(key);
+        }
+
+        auto find_position(std::size_t hash, key_type const& key) const -> size_type
+        {
+            key_equal eq{};
+            return index.find(hash, [&] (size_type position) {
+                return eq(key_array[position], key);
+            });
+        }
+
+        std::vector<key_type> key_array;
+        std::vector<mapped_type> value_array;
+        index_type index;
+    };
+}
@@ -0,0 +1,352 @@
+#pragma once
+// A hash map that guarantees iteration in insertion-order, and can also be
+// walked in key order, for C++14 or above.
+//
+// It's a `fifo_map` (an `std::list` of key/value pairs with a lookup index
+// built using `std::unordered_map`) plus a sorted index: an `std::multiset` of
+// iterators into the same list, ordered by their keys. Keys aren't copied
+// into the sorted index, and it's kept up to date by every insertion and
+// erasure, at O(log n) each.
+//
+// `begin()`/`end()` walk in insertion-order; `ordered_begin()`/`ordered_end()`,
+// `lower_bound`, `upper_bound` and `ordered_range(lo, hi)` walk in key order.
+// Keys that Compare finds equivalent but Key_Equal tells apart are all
+// kept, in insertion-order among themselves.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-key-reference.hpp"
+#include <unordered_map>
+#include <list>
+#include <set>
+#include <iterator>
+#include <type_traits>
+#include <cassert>
+
+namespace nonstd
+{
+    template <
+        class Key
+        , class T
+        , class Hash = std::hash<Key>
+        , class Key_Equal = std::equal_to<Key>
+        , class Compare = std::less<Key>
+    >
+    struct fifo_sorted_map final
+    {
+        using key_type = Key;
+        using mapped_type = T;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+        using key_compare = Compare;
+
+        using value_type = std::pair<key_type const, mapped_type>;
+        using list_type = std::list<value_type>;
+        using list_iterator = typename list_type::iterator;
+        using list_const_iterator = typename list_type::const_iterator;
+        using iterator = list_iterator;
+        using const_iterator = list_const_iterator;
+        using reverse_iterator = typename list_type::reverse_iterator;
+        using const_reverse_iterator = typename list_type::const_reverse_iterator;
+
+        using key_reference = fifo_key_reference<key_type, hasher, key_equal>;
+
+        struct key_reference_hasher final
+        {
+            auto operator () (key_reference const& kr) const -> std::size_t
+            {
+                return kr.hash();
+            }
+        };
+
+        // Orders list iterators by their keys; also compares them with keys
+        // so the sorted index can be searched by key.
+        struct key_order final
+        {
+            using is_transparent = void;
+
+            auto operator () (list_iterator a, list_iterator b) const -> bool { return key_compare{}(a->first, b->first); }
+            auto operator () (list_iterator a, key_type const& b) const -> bool { return key_compare{}(a->first, b); }
+            auto operator () (key_type const& a, list_iterator b) const -> bool { return key_compare{}(a, b->first); }
+        };
+
+        using map_type = std::unordered_map<key_reference, list_iterator, key_reference_hasher>;
+        using map_iterator = typename map_type::iterator;
+        using sorted_type = std::multiset<list_iterator, key_order>;
+        using size_type = typename map_type::size_type;
+
+        // Walks entries in key order.
+        template <bool Const>
+        struct basic_ordered_iterator final
+        {
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = fifo_sorted_map::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, value_type const*, value_type*>;
+            using reference = std::conditional_t<Const, value_type const&, value_type&>;
+
+            basic_ordered_iterator() = default;
+            explicit basic_ordered_iterator(typename sorted_type::const_iterator at): at{at} {}
+
+            // iterator -> const_iterator
+            template <bool Other, class = std::enable_if_t<Const && !Other>>
+            basic_ordered_iterator(basic_ordered_iterator<Other> const& x): at{x.base()} {}
+
+            // The same entry in insertion-order.
+            auto base() const -> typename sorted_type::const_iterator { return at; }
+            auto list_position() const -> std::conditional_t<Const, list_const_iterator, list_iterator> { return *at; }
+
+            auto operator *  () const -> reference { return **at; }
+            auto operator -> () const -> pointer { return &**at; }
+
+            auto operator ++ () -> basic_ordered_iterator& { ++at; return *this; }
+            auto operator -- () -> basic_ordered_iterator& { --at; return *this; }
+            auto operator ++ (int) -> basic_ordered_iterator { auto x = *this; ++*this; return x; }
+            auto operator -- (int) -> basic_ordered_iterator { auto x = *this; --*this; return x; }
+
+            friend auto operator == (basic_ordered_iterator const& a, basic_ordered_iterator const& b) -> bool { return a.at == b.at; }
+            friend auto operator != (basic_ordered_iterator const& a, basic_ordered_iterator const& b) -> bool { return a.at != b.at; }
+
+        private:
+            typename sorted_type::const_iterator at;
+        };
+
+        using ordered_iterator = basic_ordered_iterator<false>;
+        using const_ordered_iterator = basic_ordered_iterator<true>;
+
+        template <class Iterator>
+        struct basic_ordered_range final
+        {
+            basic_ordered_range(Iterator first, Iterator last): first{first}, last{last} {}
+
+            auto begin() const -> Iterator { return first; }
+            auto   end() const -> Iterator { return last; }
+            auto empty() const -> bool { return first == last; }
+
+        private:
+            Iterator first;
+            Iterator last;
+        };
+
+        using ordered_range_type = basic_ordered_range<ordered_iterator>;
+        using const_ordered_range_type = basic_ordered_range<const_ordered_iterator>;
+
+        // rule of five; force noexcept move constructible
+        fifo_sorted_map() = default;
+
+        fifo_sorted_map(fifo_sorted_map const& x)
+        {
+            for (auto&& kv: x)
+                emplace_back(kv);
+        }
+
+        auto operator = (fifo_sorted_map const& x) -> fifo_sorted_map&
+        {
+            if (this != &x) {
+                clear();
+                for (auto&& kv: x)
+                    emplace_back(kv);
+            }
+            return *this;
+        }
+
+        fifo_sorted_map(fifo_sorted_map&& other) noexcept
+            : map{std::move(other.map)}
+            , sorted{std::move(other.sorted)}
+            , list{std::move(other.list)}
+        {}
+
+        auto operator = (fifo_sorted_map&& other) noexcept -> fifo_sorted_map&
+        {
+            map = std::move(other.map);
+            sorted = std::move(other.sorted);
+            list = std::move(other.list);
+            return *this;
+        }
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(list.end(), std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(list.begin(), std::forward<Args>(args)...);
+        }
+
+        auto erase(list_iterator list_it) -> void
+        {
+            auto map_it = map.find(list_it->first);
+            assert(map_it != map.end());
+
+            map.erase(map_it);
+            unsort(list_it);
+            list.erase(list_it);
+        }
+
+        auto erase(key_type const& key) -> void
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end()) return;
+
+            auto list_it = map_it->second;
+            map.erase(map_it);
+            unsort(list_it);
+            list.erase(list_it);
+        }
+
+        auto clear() -> void
+        {
+            map.clear();
+            sorted.clear();
+            list.clear();
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            map.reserve(n);
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            return map.count(key);
+        }
+
+        auto size() const -> size_type
+        {
+            return map.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return map.empty();
+        }
+
+        auto find(key_type const& key) const -> const_iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return map_it->second;
+        }
+
+        auto find(key_type const& key) -> iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return map_it->second;
+        }
+
+        auto at(key_type const& key) const -> mapped_type const&
+        {
+            return map.at(key)->second;
+        }
+
+        auto at(key_type const& key) -> mapped_type&
+        {
+            return map.at(key)->second;
+        }
+
+        auto operator [] (key_type const& key) -> mapped_type&
+        {
+            auto list_it = find(key);
+            if (list_it != end())
+                return list_it->second;
+
+            return emplace(key, mapped_type{}).first->second;
+        }
+
+        // The first entry in key order whose key is not less than key.
+        auto lower_bound(key_type const& key) -> ordered_iterator { return ordered_iterator{sorted.lower_bound(key)}; }
+        auto lower_bound(key_type const& key) const -> const_ordered_iterator { return const_ordered_iterator{sorted.lower_bound(key)}; }
+
+        // The first entry in key order whose key is greater than key.
+        auto upper_bound(key_type const& key) -> ordered_iterator { return ordered_iterator{sorted.upper_bound(key)}; }
+        auto upper_bound(key_type const& key) const -> const_ordered_iterator { return const_ordered_iterator{sorted.upper_bound(key)}; }
+
+        // Entries with keys in [lo, hi), in key order.
+        auto ordered_range(key_type const& lo, key_type const& hi) -> ordered_range_type
+        {
+            if (!key_compare{}(lo, hi)) return { ordered_end(), ordered_end() };
+            return { lower_bound(lo), lower_bound(hi) };
+        }
+
+        auto ordered_range(key_type const& lo, key_type const& hi) const -> const_ordered_range_type
+        {
+            if (!key_compare{}(lo, hi)) return { ordered_end(), ordered_end() };
+            return { lower_bound(lo), lower_bound(hi) };
+        }
+
+        auto ordered_begin() -> ordered_iterator { return ordered_iterator{sorted.begin()}; }
+        auto   ordered_end() -> ordered_iterator { return ordered_iterator{sorted.  end()}; }
+        auto ordered_begin() const -> const_ordered_iterator { return const_ordered_iterator{sorted.begin()}; }
+        auto   ordered_end() const -> const_ordered_iterator { return const_ordered_iterator{sorted.  end()}; }
+
+        auto begin() -> iterator { return list.begin(); }
+        auto   end() -> iterator { return list.  end(); }
+        auto begin() const -> const_iterator { return list.begin(); }
+        auto   end() const -> const_iterator { return list.  end(); }
+        auto cbegin() const -> const_iterator { return list.cbegin(); }
+        auto   cend() const -> const_iterator { return list.  cend(); }
+        auto rbegin() -> reverse_iterator { return list.rbegin(); }
+        auto   rend() -> reverse_iterator { return list.  rend(); }
+        auto rbegin() const -> const_reverse_iterator { return list.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return list.  rend(); }
+        auto crbegin() const -> const_reverse_iterator { return list.crbegin(); }
+        auto   crend() const -> const_reverse_iterator { return list.  crend(); }
+
+        // Oldest and newest entries; the map must not be empty.
+        auto front() -> value_type& { return list.front(); }
+        auto  back() -> value_type& { return list. back(); }
+        auto front() const -> value_type const& { return list.front(); }
+        auto  back() const -> value_type const& { return list. back(); }
+
+    private:
+        // Take exactly this entry out of the sorted index.
+        auto unsort(list_iterator list_it) -> void
+        {
+            auto r = sorted.equal_range(list_it);
+            auto at = r.first;
+            while (at != r.second && *at != list_it) ++at;
+            assert(at != r.second);
+            sorted.erase(at);
+        }
+
+        template <class... Args>
+        auto insert_at(list_iterator where, Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto map_it = map.find(value.first);
+            if (map_it != map.end())
+                return { map_it->second, false };
+
+            auto front = (where == list.begin());
+            auto list_it = list.insert(where, std::move(value));
+            map.emplace(list_it->first, list_it);
+            // Equivalent keys stay in insertion-order: a front entry goes
+            // before them, a back one after.
+            if (front)
+                sorted.insert(sorted.lower_bound(list_it), list_it);
+            else
+                sorted.insert(list_it);
+            return { list_it, true };
+        }
+
+        map_type map;
+        // the same entries, by key
+        sorted_type sorted;
+        list_type list;
+    };
+}
@@ -0,0 +1,313 @@
+#pragma once
+// A hash map from strings that guarantees iteration in insertion-order,
+// for C++17 or above.
+//
+// Like `fifo_dense_map<std::string_view, T>`, except the map owns the key
+// bytes: they are copied into an append-only arena of big chunks, and every
+// entry keys into it by `std::string_view`. There are no per-entry
+// allocations for keys, short or long, and lookups take `std::string_view`
+// so finding by a literal or a slice of a buffer allocates nothing either.
+//
+// Unlike `fifo_map`, entries are kept contiguous the way `fifo_dense_map`
+// keeps them, so ERASE AND EMPLACE_FRONT ARE O(n) and invalidate iterators.
+// Use `fifo_map<std::string, T>` if you erase a lot.
+//
+// Key bytes of erased entries are reclaimed by compacting the arena
+// once they outweigh the live ones; that invalidates key views too.
+//
+// Since keys must not change behind the index's back, dereferencing an
+// iterator gives a `std::pair<std::string_view const&, T&>` by value,
+// like `fifo_soa_map` does.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "detail/position-index.hpp"
+#include "detail/string-arena.hpp"
+#include <string_view>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <stdexcept>
+
+namespace nonstd
+{
+    template <
+        class T
+        , class Hash = std::hash<std::string_view>
+        , class Key_Equal = std::equal_to<std::string_view>
+    >
+    struct fifo_string_map final
+    {
+        using key_type = std::string_view;
+        using mapped_type = T;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+
+        using value_type = std::pair<key_type, mapped_type>;
+        using vector_type = std::vector<value_type>;
+
+        using index_type = fifo_detail::position_index;
+        using size_type = typename index_type::size_type;
+
+        template <bool Const>
+        struct basic_iterator final
+        {
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = fifo_string_map::value_type;
+            using difference_type = std::ptrdiff_t;
+            using entry_pointer = std::conditional_t<Const, value_type const*, value_type*>;
+            using mapped_reference = std::conditional_t<Const, mapped_type const&, mapped_type&>;
+            using reference = std::pair<key_type const&, mapped_reference>;
+
+            struct pointer final
+            {
+                auto operator -> () -> reference* { return &r; }
+                reference r;
+            };
+
+            basic_iterator() = default;
+            explicit basic_iterator(entry_pointer at): at{at} {}
+
+            // iterator -> const_iterator
+            template <bool Other, class = std::enable_if_t<Const && !Other>>
+            basic_iterator(basic_iterator<Other> const& x): at{x.base()} {}
+
+            auto base() const -> entry_pointer { return at; }
+
+            auto operator *  () const -> reference { return { at->first, at->second }; }
+            auto operator -> () const -> pointer { return { **this }; }
+            auto operator [] (difference_type n) const -> reference { return *(*this + n); }
+
+            auto operator ++ () -> basic_iterator& { ++at; return *this; }
+            auto operator -- () -> basic_iterator& { --at; return *this; }
+            auto operator ++ (int) -> basic_iterator { auto x = *this; ++*this; return x; }
+            auto operator -- (int) -> basic_iterator { auto x = *this; --*this; return x; }
+            auto operator += (difference_type n) -> basic_iterator& { at += n; return *this; }
+            auto operator -= (difference_type n) -> basic_iterator& { at -= n; return *this; }
+
+            friend auto operator + (basic_iterator it, difference_type n) -> basic_iterator { return it += n; }
+            friend auto operator + (difference_type n, basic_iterator it) -> basic_iterator { return it += n; }
+            friend auto operator - (basic_iterator it, difference_type n) -> basic_iterator { return it -= n; }
+            friend auto operator - (basic_iterator const& a, basic_iterator const& b) -> difference_type { return a.at - b.at; }
+
+            friend auto operator == (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at == b.at; }
+            friend auto operator != (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at != b.at; }
+            friend auto operator <  (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at <  b.at; }
+            friend auto operator >  (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at >  b.at; }
+            friend auto operator <= (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at <= b.at; }
+            friend auto operator >= (basic_iterator const& a, basic_iterator const& b) -> bool { return a.at >= b.at; }
+
+        private:
+            entry_pointer at{};
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        // rule of five; copies get their own arena
+        fifo_string_map() = default;
+
+        fifo_string_map(fifo_string_map const& x)
+        {
+            reserve(x.size());
+            for (auto&& kv: x)
+                emplace_back(kv.first, kv.second);
+        }
+
+        auto operator = (fifo_string_map const& x) -> fifo_string_map&
+        {
+            if (this != &x) {
+                clear();
+                reserve(x.size());
+                for (auto&& kv: x)
+                    emplace_back(kv.first, kv.second);
+            }
+            return *this;
+        }
+
+        fifo_string_map(fifo_string_map&&) noexcept = default;
+        auto operator = (fifo_string_map&&) noexcept -> fifo_string_map& = default;
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(key_type key, Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(key, std::forward<Args>(args)...);
+        }
+
+        // The mapped value is constructed from args, only if key is new.
+        template <class... Args>
+        auto emplace_back(key_type key, Args&&... args) -> std::pair<iterator, bool>
+        {
+            auto hash = hash_of(key);
+            auto position = find_position(hash, key);
+            if (position != index_type::npos)
+                return { begin() + position, false };
+
+            index.reserve(size() + 1);
+            entries.emplace_back(
+                std::piecewise_construct,
+                std::forward_as_tuple(arena.store(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+            index.insert(hash, entries.size() - 1);
+            live_bytes += key.size();
+
+            return { end() - 1, true };
+        }
+
+        // O(n), every entry moves.
+        template <class... Args>
+        auto emplace_front(key_type key, Args&&... args) -> std::pair<iterator, bool>
+        {
+            auto hash = hash_of(key);
+            auto position = find_position(hash, key);
+            if (position != index_type::npos)
+                return { begin() + position, false };
+
+            index.reserve(size() + 1);
+            entries.emplace(
+                entries.begin(),
+                std::piecewise_construct,
+                std::forward_as_tuple(arena.store(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+            index.shift_up_from(0);
+            index.insert(hash, 0);
+            live_bytes += key.size();
+
+            return { begin(), true };
+        }
+
+        // O(n), every entry after it moves.
+        auto erase(const_iterator it) -> void
+        {
+            auto position = size_type(it - cbegin());
+            auto n = it->first.size();
+            index.erase(hash_of(it->first), position);
+            index.shift_down_after(position);
+            entries.erase(entries.begin() + position);
+
+            live_bytes -= n;
+            dead_bytes += n;
+            if (dead_bytes > live_bytes && dead_bytes > 4096)
+                compact();
+        }
+
+        auto erase(key_type key) -> void
+        {
+            auto it = find(key);
+            if (it == end()) return;
+            erase(it);
+        }
+
+        auto clear() -> void
+        {
+            index.clear();
+            entries.clear();
+            arena.clear();
+            live_bytes = dead_bytes = 0;
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            index.reserve(n);
+            entries.reserve(n);
+        }
+
+        auto count(key_type key) const -> size_type
+        {
+            return (find_position(hash_of(key), key) == index_type::npos ? 0 : 1);
+        }
+
+        auto size() const -> size_type
+        {
+            return entries.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return entries.empty();
+        }
+
+        auto find(key_type key) const -> const_iterator
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos)
+                return end();
+            return begin() + position;
+        }
+
+        auto find(key_type key) -> iterator
+        {
+            auto position = find_position(hash_of(key), key);
+            if (position == index_type::npos)
+                return end();
+            return begin() + position;
+        }
+
+        auto at(key_type key) const -> mapped_type const&
+        {
+            auto it = find(key);
+            if (it == end()) throw std::out_of_range{"fifo_string_map::at"};
+            return it->second;
+        }
+
+        auto at(key_type key) -> mapped_type&
+        {
+            auto it = find(key);
+            if (it == end()) throw std::out_of_range{"fifo_string_map::at"};
+            return it->second;
+        }
+
+        auto operator [] (key_type key) -> mapped_type&
+        {
+            return emplace(key).first->second;
+        }
+
+        // Copy the live keys into a fresh arena, dropping the bytes of erased ones.
+        auto compact() -> void
+        {
+            fifo_detail::string_arena fresh;
+            for (auto&& kv: entries)
+                kv.first = fresh.store(kv.first);
+            arena = std::move(fresh);
+            dead_bytes = 0;
+        }
+
+        auto begin() -> iterator { return iterator{entries.data()}; }
+        auto   end() -> iterator { return iterator{entries.data() + entries.size()}; }
+        auto begin() const -> const_iterator { return const_iterator{entries.data()}; }
+        auto   end() const -> const_iterator { return const_iterator{entries.data() + entries.size()}; }
+        auto cbegin() const -> const_iterator { return begin(); }
+        auto   cend() const -> const_iterator { return   end(); }
+        auto rbegin() -> reverse_iterator { return reverse_iterator{end()}; }
+        auto   rend() -> reverse_iterator { return reverse_iterator{begin()}; }
+        auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+        auto   rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+
+    private:
+        static auto hash_of(key_type key) -> std::size_t
+        {
+            hasher h{};
+            return h(key);
+        }
+
+        auto find_position(std::size_t hash, key_type key) const -> size_type
+        {
+            key_equal eq{};
+            return index.find(hash, [&] (size_type position) {
+                return eq(entries[position].first, key);
+            });
+        }
+
+        vector_type entries;
+        index_type index;
+        fifo_detail::string_arena arena;
+        size_type live_bytes{};
+        size_type dead_bytes{};
+    };
+}
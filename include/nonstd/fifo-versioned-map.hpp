@@ -0,0 +1,665 @@
+#pragma once
+// A hash map that guarantees iteration in insertion-order and can tell
+// what changed since any earlier version of itself, for C++14 or above.
+//
+// Every mutation bumps `version()` and stamps the entries it touches.
+// `diff(since)` then builds a delta of what happened after version `since`:
+// keys erased, entries inserted (and where, front or back), and values
+// assigned. `apply(delta)` replays it on a replica, which ends up equal to
+// the source, order included. Building a delta walks only the changes:
+// entries are also kept in a list ordered by their last change, and erased
+// keys in a log ordered by version.
+//
+// The erase log grows until `forget_history(version)`; diffs from before
+// a forgotten version (or from before a `clear()`) come out as a full
+// resend, with `full` set.
+//
+// For consumers that follow along instead, there's an optional bounded
+// change log: `set_change_log_capacity(n)` keeps the last n mutations,
+// which `changes_since(version)` hands out in order. And a `cursor` marks a
+// place in insertion-order that can be saved and `resume`d later, even if
+// its entry has been erased in between.
+//
+// A consistent snapshot of one version can be read out in batches while
+// the map keeps changing: after `hold_snapshot()`, the first change to an
+// entry that the snapshot hasn't reached yet saves its old value, and
+// `snapshot_batch` merges those back in. See fifo-snapshot.hpp.
+//
+// Values can't be modified through iterators, as that would bypass the
+// stamps; use `insert_or_assign` or `modify` instead.
+//
+// Copyright (C) Giumo Clanjor (哆啦比猫/兰威举), 2019-2026.
+// Licensed under the MIT License.
+
+#include "fifo-key-reference.hpp"
+#include <unordered_map>
+#include <list>
+#include <deque>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <stdexcept>
+#include <cstdint>
+#include <cassert>
+
+namespace nonstd
+{
+    template <
+        class Key
+        , class T
+        , class Hash = std::hash<Key>
+        , class Key_Equal = std::equal_to<Key>
+    >
+    struct fifo_versioned_map final
+    {
+        using key_type = Key;
+        using mapped_type = T;
+        using hasher = Hash;
+        using key_equal = Key_Equal;
+        using version_type = std::uint64_t;
+        // position in insertion-order; back inserts count up, front inserts count down
+        using ordinal_type = std::int64_t;
+
+        using value_type = std::pair<key_type const, mapped_type>;
+        using list_type = std::list<value_type>;
+        using list_iterator = typename list_type::iterator;
+        using iterator = typename list_type::const_iterator;
+        using const_iterator = typename list_type::const_iterator;
+        using reverse_iterator = typename list_type::const_reverse_iterator;
+        using const_reverse_iterator = typename list_type::const_reverse_iterator;
+
+        using key_reference = fifo_key_reference<key_type, hasher, key_equal>;
+
+        struct key_reference_hasher final
+        {
+            auto operator () (key_reference const& kr) const -> std::size_t
+            {
+                return kr.hash();
+            }
+        };
+
+        struct stamp;
+        using recent_list_type = std::list<stamp*>;
+
+        // What the index keeps for every entry.
+        struct stamp final
+        {
+            list_iterator at;
+            version_type inserted;
+            version_type modified;
+            ordinal_type ordinal;
+            // place in the list by last change
+            typename recent_list_type::iterator recent_at;
+        };
+
+        using map_type = std::unordered_map<key_reference, stamp, key_reference_hasher>;
+        using map_iterator = typename map_type::iterator;
+        using size_type = typename map_type::size_type;
+
+        // What happened between versions `from` and `to`.
+        struct delta final
+        {
+            struct insertion final
+            {
+                ordinal_type ordinal;
+                std::pair<key_type, mapped_type> entry;
+            };
+
+            version_type from{};
+            version_type to{};
+            // the replica must clear before applying the rest
+            bool full{};
+            std::vector<key_type> erased;
+            // sorted by ordinal
+            std::vector<insertion> inserted;
+            std::vector<std::pair<key_type, mapped_type>> assigned;
+
+            auto empty() const -> bool
+            {
+                return !full && erased.empty() && inserted.empty() && assigned.empty();
+            }
+        };
+
+        enum class change_kind
+        {
+            inserted_front,
+            inserted_back,
+            assigned,
+            erased,
+        };
+
+        // One mutation; values are read from the map itself.
+        struct change final
+        {
+            version_type version;
+            change_kind kind;
+            key_type key;
+        };
+
+        using change_log_type = std::deque<change>;
+        using change_iterator = typename change_log_type::const_iterator;
+
+        // Changes after some version, oldest first. If incomplete, the log
+        // doesn't reach back that far (or is off), and the consumer has to
+        // resync with `diff` or a full scan instead.
+        struct change_range final
+        {
+            change_range(change_iterator first, change_iterator last, bool complete)
+                : first{first}, last{last}, is_complete{complete} {}
+
+            auto begin() const -> change_iterator { return first; }
+            auto   end() const -> change_iterator { return last; }
+            auto empty() const -> bool { return first == last; }
+            auto complete() const -> bool { return is_complete; }
+
+        private:
+            change_iterator first;
+            change_iterator last;
+            bool is_complete;
+        };
+
+        // A place in insertion-order, just after some entry.
+        // Plain data, so it can be saved and used after a restart.
+        struct cursor final
+        {
+            ordinal_type ordinal;
+            key_type key;
+        };
+
+        // rule of five; copies start a history of their own
+        fifo_versioned_map() = default;
+
+        fifo_versioned_map(fifo_versioned_map const& x)
+            : log_capacity{x.log_capacity}
+        {
+            for (auto&& kv: x)
+                emplace_back(kv);
+        }
+
+        auto operator = (fifo_versioned_map const& x) -> fifo_versioned_map&
+        {
+            if (this != &x) {
+                clear();
+                set_change_log_capacity(x.log_capacity);
+                for (auto&& kv: x)
+                    emplace_back(kv);
+            }
+            return *this;
+        }
+
+        fifo_versioned_map(fifo_versioned_map&& other) noexcept
+            : map{std::move(other.map)}
+            , list{std::move(other.list)}
+            , recent{std::move(other.recent)}
+            , erasures{std::move(other.erasures)}
+            , current{other.current}
+            , oldest{other.oldest}
+            , next_back{other.next_back}
+            , next_front{other.next_front}
+            , log{std::move(other.log)}
+            , log_capacity{other.log_capacity}
+            , log_floor{other.log_floor}
+        {
+            // its place in the list moved with the list
+            other.release_snapshot();
+        }
+
+        auto operator = (fifo_versioned_map&& other) noexcept -> fifo_versioned_map&
+        {
+            release_snapshot();
+            map = std::move(other.map);
+            list = std::move(other.list);
+            recent = std::move(other.recent);
+            erasures = std::move(other.erasures);
+            current = other.current;
+            oldest = other.oldest;
+            next_back = other.next_back;
+            next_front = other.next_front;
+            log = std::move(other.log);
+            log_capacity = other.log_capacity;
+            log_floor = other.log_floor;
+            other.release_snapshot();
+            return *this;
+        }
+
+        // For interface compatibility with std::unordered_map.
+        template <class... Args>
+        auto emplace(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_back(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(list.end(), next_back, std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        auto emplace_front(Args&&... args) -> std::pair<iterator, bool>
+        {
+            return insert_at(list.begin(), next_front - 1, std::forward<Args>(args)...);
+        }
+
+        // Assigns if key is there, keeping its place; otherwise inserts at the back.
+        template <class M>
+        auto insert_or_assign(key_type const& key, M&& x) -> std::pair<iterator, bool>
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return emplace_back(key, std::forward<M>(x));
+
+            auto&& s = map_it->second;
+            preserve(s);
+            // a throwing assignment may have changed it half way
+            try {
+                s.at->second = std::forward<M>(x);
+            } catch (...) {
+                touch(s);
+                throw;
+            }
+            touch(s);
+            return { s.at, false };
+        }
+
+        // Calls f(mapped_type&) and stamps the entry as modified, even if
+        // f throws, as it may have changed the value before.
+        template <class F>
+        auto modify(const_iterator it, F&& f) -> void
+        {
+            auto map_it = map.find(it->first);
+            assert(map_it != map.end());
+
+            auto&& s = map_it->second;
+            preserve(s);
+            try {
+                std::forward<F>(f)(s.at->second);
+            } catch (...) {
+                touch(s);
+                throw;
+            }
+            touch(s);
+        }
+
+        auto erase(const_iterator it) -> void
+        {
+            auto map_it = map.find(it->first);
+            assert(map_it != map.end());
+            erase(map_it);
+        }
+
+        auto erase(key_type const& key) -> void
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end()) return;
+            erase(map_it);
+        }
+
+        // Diffs and changes from before this come out full or incomplete.
+        auto clear() -> void
+        {
+            for (auto&& kv: map)
+                preserve(kv.second);
+            hold.next = list.end();
+
+            map.clear();
+            list.clear();
+            recent.clear();
+            erasures.clear();
+            log.clear();
+            oldest = log_floor = ++current;
+            next_back = next_front = 0;
+        }
+
+        auto reserve(size_type n) -> void
+        {
+            map.reserve(n);
+        }
+
+        auto count(key_type const& key) const -> size_type
+        {
+            return map.count(key);
+        }
+
+        auto size() const -> size_type
+        {
+            return map.size();
+        }
+
+        auto empty() const -> bool
+        {
+            return map.empty();
+        }
+
+        auto find(key_type const& key) const -> const_iterator
+        {
+            auto map_it = map.find(key);
+            if (map_it == map.end())
+                return end();
+            return map_it->second.at;
+        }
+
+        auto at(key_type const& key) const -> mapped_type const&
+        {
+            return map.at(key).at->second;
+        }
+
+        // The latest version, bumped by every mutation.
+        auto version() const -> version_type
+        {
+            return current;
+        }
+
+        // Keeps the last n changes; 0 turns the change log off.
+        auto set_change_log_capacity(size_type n) -> void
+        {
+            if (!log_capacity) log_floor = current;
+            log_capacity = n;
+            if (!n) log.clear();
+            while (log.size() > log_capacity) {
+                log_floor = log.front().version;
+                log.pop_front();
+            }
+        }
+
+        auto change_log_capacity() const -> size_type
+        {
+            return log_capacity;
+        }
+
+        // The changes after version since, oldest first.
+        auto changes_since(version_type since) const -> change_range
+        {
+            auto first = std::upper_bound(log.begin(), log.end(), since,
+                [] (version_type v, change const& c) { return v < c.version; });
+            return { first, log.end(), log_capacity && since >= log_floor };
+        }
+
+        // Where to pick up after it.
+        auto cursor_after(const_iterator it) const -> cursor
+        {
+            return { stamp_of(it->first).ordinal, it->first };
+        }
+
+        // The first entry after c that is still there.
+        // O(1) if the entry c was taken from is still there,
+        // else a walk from the nearer end of the map.
+        auto resume(cursor const& c) const -> const_iterator
+        {
+            auto map_it = map.find(c.key);
+            if (map_it != map.end() && map_it->second.ordinal == c.ordinal)
+                return std::next(const_iterator{map_it->second.at});
+
+            // Entries are in order of their ordinals.
+            if (c.ordinal - next_front < next_back - c.ordinal) {
+                auto it = begin();
+                while (it != end() && stamp_of(it->first).ordinal <= c.ordinal) ++it;
+                return it;
+            } else {
+                auto it = end();
+                while (it != begin() && stamp_of(std::prev(it)->first).ordinal > c.ordinal) --it;
+                return it;
+            }
+        }
+
+        // Starts a snapshot of the current version, returned.
+        // There can be only one at a time.
+        auto hold_snapshot() -> version_type
+        {
+            if (hold.active) throw std::logic_error{"fifo_versioned_map::hold_snapshot: already holding one"};
+
+            hold.active = true;
+            hold.version = current;
+            hold.progress = std::numeric_limits<ordinal_type>::min();
+            hold.next = list.begin();
+            return current;
+        }
+
+        // Calls out(key, value) for the next entries of the held snapshot in
+        // order, visiting at most n entries, live or saved, so a caller
+        // holding a lock holds it for a bounded time. Returns false once the
+        // whole snapshot has been handed out, which also releases it.
+        template <class Out>
+        auto snapshot_batch(size_type n, Out&& out) -> bool
+        {
+            assert(hold.active);
+
+            // Entries unchanged since the snapshot, merged in order with the
+            // old values of entries changed since.
+            auto saved = hold.before.begin();
+            size_type visited = 0;
+            for (; visited < n && hold.next != list.end(); ++visited) {
+                auto&& s = stamp_of(hold.next->first);
+                if (saved != hold.before.end() && saved->first <= s.ordinal) {
+                    out(saved->second.first, saved->second.second);
+                    ++saved;
+                    continue;
+                }
+                if (s.modified <= hold.version)
+                    out(hold.next->first, hold.next->second);
+                ++hold.next;
+            }
+            if (hold.next == list.end()) {
+                for (; visited < n && saved != hold.before.end(); ++visited, ++saved)
+                    out(saved->second.first, saved->second.second);
+            }
+
+            auto done = (hold.next == list.end() && saved == hold.before.end());
+            auto bound = (hold.next == list.end() ? std::numeric_limits<ordinal_type>::max() : stamp_of(hold.next->first).ordinal - 1);
+            if (saved != hold.before.end() && saved->first <= bound) bound = saved->first - 1;
+
+            hold.before.erase(hold.before.begin(), saved);
+            hold.progress = bound;
+
+            if (done) release_snapshot();
+            return !done;
+        }
+
+        // Abandons the held snapshot, if any.
+        auto release_snapshot() -> void
+        {
+            hold.active = false;
+            hold.before.clear();
+        }
+
+        // Drops the erase log up to version; diffs from before it come out full.
+        auto forget_history(version_type before) -> void
+        {
+            if (before <= oldest) return;
+            if (before > current) before = current;
+
+            while (!erasures.empty() && erasures.front().erased <= before)
+                erasures.pop_front();
+            oldest = before;
+        }
+
+        // What changed after version since, up to now.
+        // O(changes), or O(n) for a full resend.
+        auto diff(version_type since) const -> delta
+        {
+            delta d;
+            d.from = since;
+            d.to = current;
+
+            if (since < oldest) {
+                d.full = true;
+                d.inserted.reserve(size());
+                for (auto&& kv: list)
+                    d.inserted.push_back({ stamp_of(kv.first).ordinal, kv });
+                return d;
+            }
+
+            // Keys that were there at since and are gone now, or have been replaced.
+            auto first = std::upper_bound(erasures.begin(), erasures.end(), since,
+                [] (version_type v, erasure const& e) { return v < e.erased; });
+            for (auto it = first; it != erasures.end(); ++it)
+                if (it->inserted <= since)
+                    d.erased.push_back(it->key);
+
+            for (auto it = recent.rbegin(); it != recent.rend() && (*it)->modified > since; ++it) {
+                auto&& s = **it;
+                if (s.inserted > since)
+                    d.inserted.push_back({ s.ordinal, *s.at });
+                else
+                    d.assigned.emplace_back(*s.at);
+            }
+
+            std::sort(d.inserted.begin(), d.inserted.end(),
+                [] (auto&& a, auto&& b) { return a.ordinal < b.ordinal; });
+            return d;
+        }
+
+        // Replays a delta of another map on this one, which must have been
+        // equal to that map at d.from (or anything, if d.full).
+        auto apply(delta const& d) -> void
+        {
+            if (d.full) clear();
+
+            for (auto&& key: d.erased)
+                erase(key);
+
+            for (auto&& a: d.assigned)
+                insert_or_assign(a.first, a.second);
+
+            // New front entries have ordinals below everything left,
+            // new back entries above; they come sorted.
+            auto lowest = (map.empty() ? ordinal_type{} : stamp_of(list.front().first).ordinal);
+            auto split = d.inserted.begin();
+            if (!map.empty())
+                while (split != d.inserted.end() && split->ordinal < lowest)
+                    ++split;
+
+            for (auto it = split; it != d.inserted.begin(); ) {
+                --it;
+                insert_at(list.begin(), it->ordinal, it->entry);
+            }
+            for (auto it = split; it != d.inserted.end(); ++it)
+                insert_at(list.end(), it->ordinal, it->entry);
+        }
+
+        auto begin() const -> const_iterator { return list.begin(); }
+        auto   end() const -> const_iterator { return list.  end(); }
+        auto cbegin() const -> const_iterator { return list.cbegin(); }
+        auto   cend() const -> const_iterator { return list.  cend(); }
+        auto rbegin() const -> const_reverse_iterator { return list.rbegin(); }
+        auto   rend() const -> const_reverse_iterator { return list.  rend(); }
+        auto crbegin() const -> const_reverse_iterator { return list.crbegin(); }
+        auto   crend() const -> const_reverse_iterator { return list.  crend(); }
+
+        // Oldest and newest entries; the map must not be empty.
+        auto front() const -> value_type const& { return list.front(); }
+        auto  back() const -> value_type const& { return list. back(); }
+
+    private:
+        struct erasure final
+        {
+            key_type key;
+            version_type inserted;
+            version_type erased;
+        };
+
+        auto stamp_of(key_type const& key) const -> stamp const&
+        {
+            auto map_it = map.find(key);
+            assert(map_it != map.end());
+            return map_it->second;
+        }
+
+        // Moves it to the newest end of the list by last change.
+        auto touch(stamp& s) -> void
+        {
+            s.modified = ++current;
+            recent.splice(recent.end(), recent, s.recent_at);
+            record(change_kind::assigned, s.at->first);
+        }
+
+        // Saves the value of an entry about to change or go, if the held
+        // snapshot still needs it.
+        auto preserve(stamp const& s) -> void
+        {
+            if (!hold.active) return;
+            if (s.inserted > hold.version || s.modified > hold.version) return;
+            if (s.ordinal <= hold.progress) return;
+            hold.before.emplace(std::piecewise_construct,
+                std::forward_as_tuple(s.ordinal),
+                std::forward_as_tuple(*s.at));
+        }
+
+        auto record(change_kind kind, key_type const& key) -> void
+        {
+            if (!log_capacity) return;
+
+            log.push_back({ current, kind, key });
+            if (log.size() > log_capacity) {
+                log_floor = log.front().version;
+                log.pop_front();
+            }
+        }
+
+        template <class... Args>
+        auto insert_at(list_iterator where, ordinal_type ordinal, Args&&... args) -> std::pair<iterator, bool>
+        {
+            value_type value{std::forward<Args>(args)...};
+
+            auto map_it = map.find(value.first);
+            if (map_it != map.end())
+                return { map_it->second.at, false };
+
+            auto list_it = list.insert(where, std::move(value));
+            ++current;
+            auto&& s = map.emplace(list_it->first, stamp{ list_it, current, current, ordinal, {} }).first->second;
+            s.recent_at = recent.insert(recent.end(), &s);
+            record((ordinal < next_front ? change_kind::inserted_front : change_kind::inserted_back), list_it->first);
+
+            if (ordinal >= next_back) next_back = ordinal + 1;
+            if (ordinal < next_front) next_front = ordinal;
+            return { list_it, true };
+        }
+
+        auto erase(map_iterator map_it) -> void
+        {
+            auto&& s = map_it->second;
+            preserve(s);
+            if (hold.active && hold.next == s.at) ++hold.next;
+            erasures.push_back({ s.at->first, s.inserted, ++current });
+            record(change_kind::erased, s.at->first);
+
+            recent.erase(s.recent_at);
+            auto list_it = s.at;
+            map.erase(map_it);
+            list.erase(list_it);
+        }
+
+        map_type map;
+        list_type list;
+        // every entry, by last change, oldest first
+        recent_list_type recent;
+        // erased keys by version
+        std::deque<erasure> erasures;
+        version_type current{};
+        // diffs from before this are full
+        version_type oldest{};
+        ordinal_type next_back{};
+        ordinal_type next_front{};
+        change_log_type log;
+        size_type log_capacity{};
+        // changes after this are all in the log
+        version_type log_floor{};
+
+        struct snapshot_hold final
+        {
+            bool active{};
+            version_type version{};
+            // entries with ordinals up to this have been handed out
+            ordinal_type progress{};
+            // next entry to look at
+            const_iterator next;
+            // old values of entries changed since, by ordinal
+            std::map<ordinal_type, std::pair<key_type, mapped_type>> before;
+        };
+        snapshot_hold hold;
+    };
+}